@@ -0,0 +1,947 @@
+/**
+	* RND64
+	* librnd64.c
+	*
+	* Reentrant generator library: the RND64 generators as a linkable API for in-process data generation.
+	*
+	* @author        Martin Latter
+	* @copyright     Martin Latter, April 2014
+	* @version       0.42 mt
+	* @license       GNU GPL version 3.0 (GPL v3); https://www.gnu.org/licenses/gpl-3.0.html
+	* @link          https://github.com/Tinram/RND64.git
+	*
+	* Stream positions are byte offsets: PCG32 contexts can seek (O(log n) state advance), so a buffer filled
+	* by rnd64_fill_parallel() is identical to the same buffer filled by rnd64_fill() from one context.
+	*
+	* The PCG32 fill loops are compiled for several ISA levels (x86-64 GCC/Clang) and the fastest one that the
+	* CPU supports is selected when the library loads: one binary for a mixed fleet, no -march rebuilds.
+	* The vector kernels run 8 PCG32 lanes, each lane 1 step ahead of the previous one and every lane jumping
+	* 8 steps per block (jump-ahead stride), so output is byte-identical to the scalar kernel.
+*/
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef __linux
+	#include <pthread.h>
+	#include <sys/sysinfo.h>
+	#include <unistd.h>
+	#include <fcntl.h>
+	#define RANDOM_PATH "/dev/urandom"
+#elif _WIN64
+	#include <windows.h>
+	#include <wincrypt.h> /* CryptAcquireContext, CryptGenRandom */
+#endif
+
+#include "librnd64.h"
+
+
+/* constants */
+static size_t const cSLICE_MIN = 0x10000; /* smallest per-thread slice for rnd64_fill_parallel() */
+static uint64_t const cPCG_MULT = 6364136223846793005ULL;
+
+
+/* structs */
+typedef struct {
+	uint64_t state;
+	uint64_t inc;
+} pcg32_random_t;
+
+typedef void (*PcgKernel_t)(pcg32_random_t* rng, uint8_t* pOut, size_t iCount);
+
+typedef struct {
+	char const* sName;
+	PcgKernel_t pWords;        /* iCount 32-bit words: RND64_MODE_ALL */
+	PcgKernel_t pChars;        /* iCount characters 33-126: RND64_MODE_RESTRICTED */
+	int (*pSupported)(void);
+	int iAuto;                 /* candidate for automatic selection */
+} IsaKernels_t;
+
+struct rnd64_ctx {
+	rnd64_mode_t iMode;
+	rnd64_engine_t iEngine;
+	uint64_t iSeed;
+	uint64_t iOrigin;          /* PCG state at stream offset 0 */
+	uint64_t iPos;             /* stream offset in bytes */
+	pcg32_random_t rng;
+	uint8_t aCarry[4];         /* unconsumed bytes of the last PCG word (RND64_MODE_ALL) */
+	unsigned int iCarryLen;
+
+	#ifdef __linux
+		int iUrand;
+	#elif _WIN64
+		HCRYPTPROV rCryptHandle;
+	#endif
+};
+
+typedef struct {
+	rnd64_ctx_t ctx;
+	uint8_t* pBuf;
+	size_t iLen;
+	int iResult;
+} FillJob_t;
+
+
+/**
+	* pcg32_random fast random number generator (minimal PCG32 version)
+	* (c) 2014 Professor Melissa E. O'Neill - pcg-random.org
+	* Apache License 2.0
+	*
+	* @param   pcg32_random_t* rng
+	* @return  uint32_t
+*/
+
+static inline uint32_t pcg32_random_r(pcg32_random_t* rng)
+{
+	uint64_t oldstate = rng->state;
+
+	/* advance internal state */
+	rng->state = oldstate * cPCG_MULT + rng->inc;
+
+	/* calculate output function (XSH RR), uses old state for max ILP */
+	uint32_t xorshifted = ((oldstate >> 18u) ^ oldstate) >> 27u;
+	uint32_t rot = oldstate >> 59u;
+
+	return (xorshifted >> rot) | (xorshifted << ((-rot) & 31));
+}
+
+
+/**
+	* Coefficients of a PCG32 jump of iDelta steps, state' = iMult * state + iPlus, in O(log iDelta)
+	* (Brown, "Random Number Generation with Arbitrary Stride").
+	* (c) 2014 Professor Melissa E. O'Neill - pcg-random.org
+	* Apache License 2.0
+	*
+	* @param   uint64_t iDelta, number of steps
+	* @param   uint64_t iInc, stream increment (odd)
+	* @param   uint64_t* pMult, multiplier, populated
+	* @param   uint64_t* pPlus, increment, populated
+	* @return  void
+*/
+
+static void pcg32_stride(uint64_t iDelta, uint64_t iInc, uint64_t* pMult, uint64_t* pPlus) {
+
+	uint64_t iCurMult = cPCG_MULT;
+	uint64_t iCurPlus = iInc;
+	uint64_t iAccMult = 1;
+	uint64_t iAccPlus = 0;
+
+	while (iDelta > 0) {
+
+		if (iDelta & 1) {
+			iAccMult *= iCurMult;
+			iAccPlus = iAccPlus * iCurMult + iCurPlus;
+		}
+
+		iCurPlus = (iCurMult + 1) * iCurPlus;
+		iCurMult *= iCurMult;
+		iDelta /= 2;
+	}
+
+	*pMult = iAccMult;
+	*pPlus = iAccPlus;
+}
+
+
+/**
+	* Advance a PCG32 state by iDelta steps in O(log iDelta).
+	*
+	* @param   uint64_t iState, state to advance
+	* @param   uint64_t iDelta, number of steps
+	* @param   uint64_t iInc, stream increment (odd)
+	* @return  uint64_t, advanced state
+*/
+
+static uint64_t pcg32_advance(uint64_t iState, uint64_t iDelta, uint64_t iInc) {
+
+	uint64_t iMult = 0;
+	uint64_t iPlus = 0;
+
+	pcg32_stride(iDelta, iInc, &iMult, &iPlus);
+
+	return iMult * iState + iPlus;
+}
+
+
+/**
+	* Scalar kernel: iCount PCG32 words.
+	*
+	* @param   pcg32_random_t* rng
+	* @param   uint8_t* pOut, destination (iCount * 4 bytes)
+	* @param   size_t iCount, words
+	* @return  void
+*/
+
+static void wordsScalar(pcg32_random_t* rng, uint8_t* pOut, size_t iCount) {
+
+	for (size_t i = 0; i < iCount; i++) {
+		uint32_t iWord = pcg32_random_r(rng);
+		memcpy(pOut + i * 4, &iWord, 4);
+	}
+}
+
+
+/**
+	* Scalar kernel: iCount printable characters, one draw per character, multiply-shift range reduction.
+	*
+	* @param   pcg32_random_t* rng
+	* @param   uint8_t* pOut, destination
+	* @param   size_t iCount, characters
+	* @return  void
+*/
+
+static void charsScalar(pcg32_random_t* rng, uint8_t* pOut, size_t iCount) {
+
+	for (size_t i = 0; i < iCount; i++) {
+		pOut[i] = (uint8_t) ((((uint64_t) pcg32_random_r(rng) * 94) >> 32) + 33);
+	}
+}
+
+
+static int isaScalar(void) {
+
+	return 1;
+}
+
+
+#if defined(__x86_64__) && defined(__GNUC__)
+
+/* two 4-lane halves: one register each under AVX2, no 64-byte spills */
+typedef uint64_t u64x4_t __attribute__((vector_size(32)));
+typedef uint32_t u32x4_t __attribute__((vector_size(16)));
+
+
+/**
+	* PCG32 XSH RR output of 4 lanes.
+	*
+	* @param   u64x4_t* pOld, lane states before the step (by pointer: no 32-byte by-value ABI)
+	* @return  u32x4_t
+*/
+
+static inline __attribute__((always_inline)) u32x4_t pcg32_output_x4(u64x4_t const* pOld) {
+
+	u64x4_t vOld = *pOld;
+	u32x4_t vXorShifted = __builtin_convertvector(((vOld >> 18u) ^ vOld) >> 27u, u32x4_t);
+	u32x4_t vRot = __builtin_convertvector(vOld >> 59u, u32x4_t);
+
+	return (vXorShifted >> vRot) | (vXorShifted << ((-vRot) & 31));
+}
+
+
+/**
+	* 8-lane word kernel body, instantiated per ISA by the target() wrappers below.
+	* Lane j starts j steps ahead of rng and every lane jumps 8 steps per block, so block b holds words 8b .. 8b+7.
+	*
+	* @param   pcg32_random_t* rng
+	* @param   uint8_t* pOut, destination (iCount * 4 bytes)
+	* @param   size_t iCount, words
+	* @return  void
+*/
+
+static inline __attribute__((always_inline)) void pcg32_lanes(pcg32_random_t* rng, uint8_t* pOut, size_t iCount) {
+
+	size_t iBlocks = iCount / 8;
+	uint64_t aLanes[8];
+	uint64_t iMult = 0;
+	uint64_t iPlus = 0;
+	u64x4_t vLo;
+	u64x4_t vHi;
+
+	for (unsigned int j = 0; j < 8; j++) {
+		aLanes[j] = (j == 0) ? rng->state : aLanes[j - 1] * cPCG_MULT + rng->inc;
+	}
+
+	pcg32_stride(8, rng->inc, &iMult, &iPlus);
+
+	memcpy(&vLo, aLanes, sizeof(vLo));
+	memcpy(&vHi, aLanes + 4, sizeof(vHi));
+
+	for (size_t b = 0; b < iBlocks; b++) {
+
+		u32x4_t vWordsLo = pcg32_output_x4(&vLo);
+		u32x4_t vWordsHi = pcg32_output_x4(&vHi);
+
+		vLo = vLo * iMult + iPlus;
+		vHi = vHi * iMult + iPlus;
+
+		memcpy(pOut + b * 32, &vWordsLo, 16);
+		memcpy(pOut + b * 32 + 16, &vWordsHi, 16);
+	}
+
+	/* lane 0 is now 8 * iBlocks steps on */
+	rng->state = vLo[0];
+
+	wordsScalar(rng, pOut + iBlocks * 32, iCount % 8);
+}
+
+
+/**
+	* Character kernel body: words in L1-sized batches, then a range-reduction loop the compiler vectorises for the target.
+	*
+	* @param   pcg32_random_t* rng
+	* @param   uint8_t* pOut, destination
+	* @param   size_t iCount, characters
+	* @return  void
+*/
+
+static inline __attribute__((always_inline)) void pcg32_lanes_chars(pcg32_random_t* rng, uint8_t* pOut, size_t iCount) {
+
+	uint32_t aWords[1024];
+
+	while (iCount > 0) {
+
+		size_t iBatch = (iCount < 1024) ? iCount : 1024;
+
+		pcg32_lanes(rng, (uint8_t*) aWords, iBatch);
+
+		for (size_t i = 0; i < iBatch; i++) {
+			pOut[i] = (uint8_t) ((((uint64_t) aWords[i] * 94) >> 32) + 33);
+		}
+
+		pOut += iBatch;
+		iCount -= iBatch;
+	}
+}
+
+
+static void wordsSse2(pcg32_random_t* rng, uint8_t* pOut, size_t iCount) {
+
+	pcg32_lanes(rng, pOut, iCount);
+}
+
+static void charsSse2(pcg32_random_t* rng, uint8_t* pOut, size_t iCount) {
+
+	pcg32_lanes_chars(rng, pOut, iCount);
+}
+
+static int isaSse2(void) {
+
+	return __builtin_cpu_supports("sse2");
+}
+
+
+__attribute__((target("avx2"))) static void wordsAvx2(pcg32_random_t* rng, uint8_t* pOut, size_t iCount) {
+
+	pcg32_lanes(rng, pOut, iCount);
+}
+
+__attribute__((target("avx2"))) static void charsAvx2(pcg32_random_t* rng, uint8_t* pOut, size_t iCount) {
+
+	pcg32_lanes_chars(rng, pOut, iCount);
+}
+
+static int isaAvx2(void) {
+
+	return __builtin_cpu_supports("avx2");
+}
+
+
+/* AVX-512DQ: native 64-bit lane multiply (vpmullq) */
+__attribute__((target("avx512f,avx512dq,avx512bw,avx512vl"))) static void wordsAvx512(pcg32_random_t* rng, uint8_t* pOut, size_t iCount) {
+
+	pcg32_lanes(rng, pOut, iCount);
+}
+
+__attribute__((target("avx512f,avx512dq,avx512bw,avx512vl"))) static void charsAvx512(pcg32_random_t* rng, uint8_t* pOut, size_t iCount) {
+
+	pcg32_lanes_chars(rng, pOut, iCount);
+}
+
+static int isaAvx512(void) {
+
+	return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq") && __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512vl");
+}
+
+#endif
+
+
+/* kernels in ascending preference; SSE2 has no 64-bit lane multiply and loses to scalar, so it is selectable but not automatic */
+static IsaKernels_t const aIsaKernels[] = {
+	{"scalar", wordsScalar, charsScalar, isaScalar, 1},
+	#if defined(__x86_64__) && defined(__GNUC__)
+		{"sse2",   wordsSse2,   charsSse2,   isaSse2,   0},
+		{"avx2",   wordsAvx2,   charsAvx2,   isaAvx2,   1},
+		{"avx512", wordsAvx512, charsAvx512, isaAvx512, 1},
+	#endif
+};
+
+static IsaKernels_t const* pIsa = &aIsaKernels[0];
+
+
+/**
+	* Select the kernels at library load, before any thread can fill.
+	*
+	* @param   void
+	* @return  void
+*/
+
+__attribute__((constructor)) static void isaInit(void) {
+
+	#if defined(__x86_64__) && defined(__GNUC__)
+		__builtin_cpu_init();
+	#endif
+
+	rnd64_set_isa("auto");
+}
+
+
+/**
+	* Create a non-zero seed from the OS entropy source, falling back on time and address.
+	*
+	* @param   void
+	* @return  uint64_t
+*/
+
+static uint64_t autoSeed(void) {
+
+	uint64_t iSeed = 0;
+
+	#ifdef __linux
+
+		int iUrand = open(RANDOM_PATH, O_RDONLY);
+
+		if (iUrand >= 0) {
+
+			if (read(iUrand, &iSeed, sizeof(iSeed)) != sizeof(iSeed)) {
+				iSeed = 0;
+			}
+
+			close(iUrand);
+		}
+
+	#elif _WIN64
+
+		HCRYPTPROV rCryptHandle = 0;
+
+		if (CryptAcquireContext(&rCryptHandle, NULL, NULL, PROV_RSA_FULL, CRYPT_VERIFYCONTEXT)) {
+			CryptGenRandom(rCryptHandle, sizeof(iSeed), (BYTE*) &iSeed);
+			CryptReleaseContext(rCryptHandle, 0);
+		}
+
+	#endif
+
+	if (iSeed == 0) {
+		iSeed = ((uint64_t) time(NULL) << 20) ^ (uint64_t) clock() ^ (uint64_t) (uintptr_t) &iSeed;
+	}
+
+	return iSeed | (iSeed == 0);
+}
+
+
+/**
+	* Open the crypto engine source for a context.
+	*
+	* @param   rnd64_ctx_t* pCtx
+	* @return  int, 0 on success, -1 on failure
+*/
+
+static int openCrypto(rnd64_ctx_t* pCtx) {
+
+	#ifdef __linux
+
+		pCtx->iUrand = -1;
+
+		if (pCtx->iEngine == RND64_ENGINE_CRYPTO) {
+
+			pCtx->iUrand = open(RANDOM_PATH, O_RDONLY);
+
+			if (pCtx->iUrand < 0) {
+				return -1;
+			}
+		}
+
+	#elif _WIN64
+
+		pCtx->rCryptHandle = 0;
+
+		if (pCtx->iEngine == RND64_ENGINE_CRYPTO) {
+
+			if (CryptAcquireContext(&pCtx->rCryptHandle, NULL, NULL, PROV_RSA_FULL, CRYPT_VERIFYCONTEXT) == FALSE) {
+				return -1;
+			}
+		}
+
+	#endif
+
+	return 0;
+}
+
+
+/**
+	* Create a generator context.
+	*
+	* @param   rnd64_mode_t iMode, output character set
+	* @param   rnd64_engine_t iEngine, random source
+	* @param   uint64_t iSeed, PCG32 seed; 0 for an automatic seed
+	* @return  rnd64_ctx_t*, NULL on invalid mode/engine or unavailable crypto source
+*/
+
+rnd64_ctx_t* rnd64_create(rnd64_mode_t iMode, rnd64_engine_t iEngine, uint64_t iSeed) {
+
+	rnd64_ctx_t* pCtx;
+
+	if (iMode > RND64_MODE_RESTRICTED || iEngine > RND64_ENGINE_CRYPTO) {
+		return NULL;
+	}
+
+	if (iEngine == RND64_ENGINE_CRYPTO && iMode == RND64_MODE_RESTRICTED) {
+		return NULL;
+	}
+
+	pCtx = (rnd64_ctx_t*) calloc(1, sizeof(rnd64_ctx_t));
+
+	if (pCtx == NULL) {
+		return NULL;
+	}
+
+	pCtx->iMode = iMode;
+	pCtx->iEngine = iEngine;
+	pCtx->iSeed = (iSeed != 0) ? iSeed : autoSeed();
+
+	rnd64_stream(pCtx, 0);
+
+	if (openCrypto(pCtx) != 0) {
+		free(pCtx);
+		return NULL;
+	}
+
+	return pCtx;
+}
+
+
+/**
+	* Create an independent copy of a context at the same stream position, for use in another thread.
+	*
+	* @param   rnd64_ctx_t* pCtx
+	* @return  rnd64_ctx_t*, NULL on failure
+*/
+
+rnd64_ctx_t* rnd64_clone(rnd64_ctx_t const* pCtx) {
+
+	rnd64_ctx_t* pClone = (rnd64_ctx_t*) malloc(sizeof(rnd64_ctx_t));
+
+	if (pClone == NULL) {
+		return NULL;
+	}
+
+	*pClone = *pCtx;
+
+	if (openCrypto(pClone) != 0) {
+		free(pClone);
+		return NULL;
+	}
+
+	return pClone;
+}
+
+
+/**
+	* Release a context.
+	*
+	* @param   rnd64_ctx_t* pCtx
+	* @return  void
+*/
+
+void rnd64_destroy(rnd64_ctx_t* pCtx) {
+
+	if (pCtx == NULL) {
+		return;
+	}
+
+	#ifdef __linux
+		if (pCtx->iUrand >= 0) {
+			close(pCtx->iUrand);
+		}
+	#elif _WIN64
+		if (pCtx->rCryptHandle) {
+			CryptReleaseContext(pCtx->rCryptHandle, 0);
+		}
+	#endif
+
+	free(pCtx);
+}
+
+
+/**
+	* Position a context at a byte offset of its stream.
+	* Crypto streams have no position: the offset is recorded only.
+	*
+	* @param   rnd64_ctx_t* pCtx
+	* @param   uint64_t iOffset, byte offset from the start of the stream
+	* @return  void
+*/
+
+void rnd64_seek(rnd64_ctx_t* pCtx, uint64_t iOffset) {
+
+	pCtx->iPos = iOffset;
+	pCtx->iCarryLen = 0;
+
+	if (pCtx->iEngine != RND64_ENGINE_PCG32) {
+		return;
+	}
+
+	if (pCtx->iMode == RND64_MODE_ALL) {
+
+		pCtx->rng.state = pcg32_advance(pCtx->iOrigin, iOffset / 4, pCtx->rng.inc);
+
+		if (iOffset % 4) {
+
+			uint32_t iWord = pcg32_random_r(&pCtx->rng);
+			unsigned int iSkip = iOffset % 4;
+
+			memcpy(pCtx->aCarry + iSkip, (uint8_t*) &iWord + iSkip, 4 - iSkip);
+			pCtx->iCarryLen = 4 - iSkip;
+		}
+	}
+	else if (pCtx->iMode == RND64_MODE_RESTRICTED) {
+		pCtx->rng.state = pcg32_advance(pCtx->iOrigin, iOffset, pCtx->rng.inc);
+	}
+}
+
+
+/**
+	* Switch a context to an independent PCG32 stream of its seed, positioned at offset 0.
+	* Streams give distinct, reproducible outputs per seed, e.g. one stream per generated file.
+	*
+	* @param   rnd64_ctx_t* pCtx
+	* @param   uint64_t iStream, stream number
+	* @return  void
+*/
+
+void rnd64_stream(rnd64_ctx_t* pCtx, uint64_t iStream) {
+
+	/* pcg32_srandom_r(): seed selects the state, stream selects the increment */
+	pCtx->rng.inc = (iStream << 1u) | 1u;
+	pCtx->rng.state = 0;
+	pcg32_random_r(&pCtx->rng);
+	pCtx->rng.state += pCtx->iSeed;
+	pcg32_random_r(&pCtx->rng);
+
+	pCtx->iOrigin = pCtx->rng.state;
+	pCtx->iPos = 0;
+	pCtx->iCarryLen = 0;
+}
+
+
+/**
+	* Fill a buffer with the next iLen bytes of the context's stream.
+	*
+	* @param   rnd64_ctx_t* pCtx
+	* @param   void* pBuf, destination
+	* @param   size_t iLen, bytes
+	* @return  int, 0 on success, -1 if the crypto source failed
+*/
+
+int rnd64_fill(rnd64_ctx_t* pCtx, void* pBuf, size_t iLen) {
+
+	uint8_t* pOut = (uint8_t*) pBuf;
+	size_t iRemain = iLen;
+
+	if (pCtx->iMode == RND64_MODE_SINGLE) {
+
+		memset(pOut, 0, iLen);
+	}
+	else if (pCtx->iEngine == RND64_ENGINE_CRYPTO) {
+
+		#ifdef __linux
+
+			while (iRemain > 0) {
+
+				ssize_t iRead = read(pCtx->iUrand, pOut, iRemain);
+
+				if (iRead <= 0) {
+					return -1;
+				}
+
+				pOut += iRead;
+				iRemain -= (size_t) iRead;
+			}
+
+		#elif _WIN64
+
+			while (iRemain > 0) {
+
+				DWORD iChunk = (iRemain > 0x40000000) ? 0x40000000 : (DWORD) iRemain;
+
+				if (CryptGenRandom(pCtx->rCryptHandle, iChunk, (BYTE*) pOut) == FALSE) {
+					return -1;
+				}
+
+				pOut += iChunk;
+				iRemain -= iChunk;
+			}
+
+		#endif
+	}
+	else if (pCtx->iMode == RND64_MODE_ALL) {
+
+		/* bytes left over from the previous call's last word */
+		while (pCtx->iCarryLen > 0 && iRemain > 0) {
+			*pOut++ = pCtx->aCarry[4 - pCtx->iCarryLen];
+			pCtx->iCarryLen--;
+			iRemain--;
+		}
+
+		size_t iWords = iRemain / 4;
+
+		pIsa->pWords(&pCtx->rng, pOut, iWords);
+
+		pOut += iWords * 4;
+		iRemain %= 4;
+
+		if (iRemain > 0) {
+
+			uint32_t iWord = pcg32_random_r(&pCtx->rng);
+
+			memcpy(pOut, &iWord, iRemain);
+			memcpy(pCtx->aCarry + iRemain, (uint8_t*) &iWord + iRemain, 4 - iRemain);
+			pCtx->iCarryLen = 4 - iRemain;
+		}
+	}
+	else { /* RND64_MODE_RESTRICTED */
+
+		pIsa->pChars(&pCtx->rng, pOut, iRemain);
+	}
+
+	pCtx->iPos += iLen;
+
+	return 0;
+}
+
+
+/**
+	* Thread function: fill one slice for rnd64_fill_parallel().
+	*
+	* @param   void pointer st, FillJob_t struct
+	* @return  void* / null
+*/
+
+#ifdef __linux
+	static void* fillSlice(void* st)
+#elif _WIN64
+	static DWORD WINAPI fillSlice(LPVOID st)
+#endif
+
+	{
+		FillJob_t* pJob = (FillJob_t*) st;
+
+		pJob->iResult = rnd64_fill(&pJob->ctx, pJob->pBuf, pJob->iLen);
+
+		return 0;
+	}
+
+
+/**
+	* Fill a buffer using multiple threads.
+	* PCG32 output is identical to rnd64_fill() on the same context; the context is advanced past the buffer.
+	*
+	* @param   rnd64_ctx_t* pCtx
+	* @param   void* pBuf, destination
+	* @param   size_t iLen, bytes
+	* @param   unsigned int iThreads, 0 for one thread per logical CPU
+	* @return  int, 0 on success, -1 on failure
+*/
+
+int rnd64_fill_parallel(rnd64_ctx_t* pCtx, void* pBuf, size_t iLen, unsigned int iThreads) {
+
+	uint8_t* pOut = (uint8_t*) pBuf;
+	uint64_t iBase = pCtx->iPos;
+	size_t iLead = 0;
+	size_t iSlice = 0;
+	int iResult = 0;
+	unsigned int iStarted = 0;
+
+	if (iThreads == 0) {
+		iThreads = rnd64_cpu_count();
+	}
+
+	if (iLen / iThreads < cSLICE_MIN) {
+		iThreads = (unsigned int) (iLen / cSLICE_MIN);
+	}
+
+	if (iThreads < 2) {
+		return rnd64_fill(pCtx, pBuf, iLen);
+	}
+
+	FillJob_t* aJobs = (FillJob_t*) calloc(iThreads, sizeof(FillJob_t));
+
+	#ifdef __linux
+		pthread_t* rThreadID = (pthread_t*) calloc(iThreads, sizeof(pthread_t));
+	#elif _WIN64
+		HANDLE* rThreadID = (HANDLE*) calloc(iThreads, sizeof(HANDLE));
+	#endif
+
+	if (aJobs == NULL || rThreadID == NULL) {
+		free(aJobs);
+		free(rThreadID);
+		return rnd64_fill(pCtx, pBuf, iLen);
+	}
+
+	/* consume carried bytes so that every slice starts on a word boundary */
+	iLead = pCtx->iCarryLen;
+
+	if (rnd64_fill(pCtx, pOut, iLead) != 0) {
+		free(aJobs);
+		free(rThreadID);
+		return -1;
+	}
+
+	iBase += iLead;
+	iSlice = ((iLen - iLead) / iThreads) & ~(size_t) 3;
+
+	for (unsigned int i = 0; i < iThreads; i++) {
+
+		aJobs[i].ctx = *pCtx;
+		aJobs[i].pBuf = pOut + iLead + i * iSlice;
+		aJobs[i].iLen = (i == iThreads - 1) ? (iLen - iLead) - i * iSlice : iSlice;
+		aJobs[i].iResult = 0;
+
+		rnd64_seek(&aJobs[i].ctx, iBase + i * iSlice);
+
+		/* slices that cannot get a thread are filled on the calling thread */
+		if (iStarted < i) {
+			fillSlice(&aJobs[i]);
+			continue;
+		}
+
+		#ifdef __linux
+			if (pthread_create(&rThreadID[i], NULL, fillSlice, &aJobs[i]) != 0) {
+				fillSlice(&aJobs[i]);
+				continue;
+			}
+		#elif _WIN64
+			rThreadID[i] = CreateThread(NULL, 0, fillSlice, &aJobs[i], 0, NULL);
+
+			if (rThreadID[i] == NULL) {
+				fillSlice(&aJobs[i]);
+				continue;
+			}
+		#endif
+
+		iStarted++;
+	}
+
+	for (unsigned int i = 0; i < iThreads; i++) {
+
+		if (i < iStarted) {
+			#ifdef __linux
+				pthread_join(rThreadID[i], NULL);
+			#elif _WIN64
+				WaitForSingleObject(rThreadID[i], INFINITE);
+				CloseHandle(rThreadID[i]);
+			#endif
+		}
+
+		iResult |= aJobs[i].iResult;
+	}
+
+	/* continue the stream after the buffer: the last slice holds any trailing carry */
+	*pCtx = aJobs[iThreads - 1].ctx;
+
+	free(aJobs);
+	free(rThreadID);
+
+	return iResult;
+}
+
+
+/**
+	* Return the seed of a context, e.g. to reproduce an automatically-seeded run.
+	*
+	* @param   rnd64_ctx_t* pCtx
+	* @return  uint64_t
+*/
+
+uint64_t rnd64_seed(rnd64_ctx_t const* pCtx) {
+
+	return pCtx->iSeed;
+}
+
+
+/**
+	* Return the current stream offset of a context.
+	*
+	* @param   rnd64_ctx_t* pCtx
+	* @return  uint64_t
+*/
+
+uint64_t rnd64_tell(rnd64_ctx_t const* pCtx) {
+
+	return pCtx->iPos;
+}
+
+
+/**
+	* Select the fill kernels by ISA name; "auto" (or NULL) picks the fastest that the CPU supports.
+	* Not thread-safe: call before generating.
+	*
+	* @param   char* sIsa, auto | scalar | sse2 | avx2 | avx512
+	* @return  int, 0 on success, -1 if unknown or unsupported by this CPU
+*/
+
+int rnd64_set_isa(char const* sIsa) {
+
+	size_t iKernels = sizeof(aIsaKernels) / sizeof(aIsaKernels[0]);
+
+	if (sIsa == NULL || strcmp(sIsa, "auto") == 0) {
+
+		for (size_t i = 0; i < iKernels; i++) {
+
+			if (aIsaKernels[i].iAuto && aIsaKernels[i].pSupported()) {
+				pIsa = &aIsaKernels[i];
+			}
+		}
+
+		return 0;
+	}
+
+	for (size_t i = 0; i < iKernels; i++) {
+
+		if (strcmp(sIsa, aIsaKernels[i].sName) == 0) {
+
+			if ( ! aIsaKernels[i].pSupported()) {
+				return -1;
+			}
+
+			pIsa = &aIsaKernels[i];
+			return 0;
+		}
+	}
+
+	return -1;
+}
+
+
+/**
+	* Return the name of the selected fill kernels.
+	*
+	* @param   void
+	* @return  char*
+*/
+
+char const* rnd64_isa(void) {
+
+	return pIsa->sName;
+}
+
+
+/**
+	* Detect number of CPU threads (logical cores, not physical cores, Intel i3 = 4: 2 cores + 2 threads).
+	*
+	* @param   void
+	* @return  unsigned int
+*/
+
+unsigned int rnd64_cpu_count(void) {
+
+	#ifdef __linux
+		int iProcs = get_nprocs();
+		return (iProcs > 0) ? (unsigned int) iProcs : 1;
+	#elif _WIN64
+		SYSTEM_INFO siSysInfo;
+		GetSystemInfo(&siSysInfo);
+		return (unsigned int) siSysInfo.dwNumberOfProcessors;
+	#endif
+}
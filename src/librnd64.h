@@ -0,0 +1,73 @@
+/**
+	* RND64
+	* librnd64.h
+	*
+	* Reentrant generator library: the RND64 generators as a linkable API for in-process data generation.
+	*
+	* @author        Martin Latter
+	* @copyright     Martin Latter, April 2014
+	* @version       0.42 mt
+	* @license       GNU GPL version 3.0 (GPL v3); https://www.gnu.org/licenses/gpl-3.0.html
+	* @link          https://github.com/Tinram/RND64.git
+	*
+	* Usage:
+	*
+	*        rnd64_ctx_t* pCtx = rnd64_create(RND64_MODE_ALL, RND64_ENGINE_PCG32, 42);
+	*        rnd64_fill(pCtx, aBuffer, sizeof(aBuffer));
+	*        rnd64_fill_parallel(pCtx, pLarge, iLargeSize, 0);
+	*        rnd64_destroy(pCtx);
+	*
+	*        A context is not shared between threads: use rnd64_clone() for each thread, or rnd64_fill_parallel().
+	*
+	*        Fill kernels are chosen for the CPU at load time: rnd64_set_isa("scalar") etc. overrides for testing.
+*/
+
+
+#ifndef LIBRND64_H
+#define LIBRND64_H
+
+
+#include <stddef.h>
+#include <inttypes.h>
+
+
+/* defines */
+#define LIBRND64_VERSION "0.42 mt"
+
+
+/* enums */
+typedef enum {
+	RND64_MODE_ALL = 0,          /* bytes 0-255 */
+	RND64_MODE_SINGLE,           /* null bytes */
+	RND64_MODE_RESTRICTED        /* printable ASCII 33-126 */
+} rnd64_mode_t;
+
+typedef enum {
+	RND64_ENGINE_PCG32 = 0,      /* PCG32, seedable and seekable */
+	RND64_ENGINE_CRYPTO          /* Linux: /dev/urandom, Windows: CryptGenRandom; RND64_MODE_ALL only */
+} rnd64_engine_t;
+
+
+/* structs */
+typedef struct rnd64_ctx rnd64_ctx_t;
+
+
+/* functions */
+rnd64_ctx_t* rnd64_create(rnd64_mode_t iMode, rnd64_engine_t iEngine, uint64_t iSeed);
+rnd64_ctx_t* rnd64_clone(rnd64_ctx_t const* pCtx);
+void rnd64_destroy(rnd64_ctx_t* pCtx);
+
+int rnd64_fill(rnd64_ctx_t* pCtx, void* pBuf, size_t iLen);
+int rnd64_fill_parallel(rnd64_ctx_t* pCtx, void* pBuf, size_t iLen, unsigned int iThreads);
+void rnd64_seek(rnd64_ctx_t* pCtx, uint64_t iOffset);
+void rnd64_stream(rnd64_ctx_t* pCtx, uint64_t iStream);
+
+uint64_t rnd64_seed(rnd64_ctx_t const* pCtx);
+uint64_t rnd64_tell(rnd64_ctx_t const* pCtx);
+unsigned int rnd64_cpu_count(void);
+
+int rnd64_set_isa(char const* sIsa);
+char const* rnd64_isa(void);
+
+
+#endif
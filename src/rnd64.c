@@ -12,13 +12,11 @@
 	* @link          https://github.com/Tinram/RND64.git
 	*
 	* Compile (GCC x64):
-	*                    Linux:      gcc rnd64.c -o rnd64 -lpthread -O3 -Wall -Wextra -Wuninitialized -Wunused -Werror -std=gnu99 -s
-	*                    Windows:    gcc rnd64.c -o rnd64.exe -O3 -Wall -Wextra -Wuninitialized -Wunused -Werror -std=c99 -s
+	*                    Linux:      gcc rnd64.c rnd64_fanout.c rnd64_tree.c rnd64_net.c rnd64_tune.c rnd64_analyze.c rnd64_selftest.c rnd64_stress.c rnd64_overwrite.c rnd64_randwrite.c rnd64_mutate.c rnd64_tar.c rnd64_output.c rnd64_arena.c librnd64.c -o rnd64 -lpthread -lm -O3 -Wall -Wextra -Wuninitialized -Wunused -Werror -std=gnu99 -s
+	*                    Windows:    gcc rnd64.c rnd64_fanout.c rnd64_tree.c rnd64_net.c rnd64_tune.c rnd64_analyze.c rnd64_selftest.c rnd64_stress.c rnd64_overwrite.c rnd64_randwrite.c rnd64_mutate.c rnd64_tar.c rnd64_output.c rnd64_arena.c librnd64.c -o rnd64.exe -O3 -Wall -Wextra -Wuninitialized -Wunused -Werror -std=c99 -s
 	*
-	*                    further CPU optimisation examples:
-	*                                -mtune=native -march=native                    current CPU
-	*                                -march=core-avx2 -mtune=core-avx2              Intel Haswell
-	*                                -march=skylake-avx512 -mtune=skylake-avx512    Intel Skylake
+	*                    generation kernels are built for SSE2, AVX2 and AVX-512 and selected at startup (--isa overrides),
+	*                    -march is not needed for a fast binary
 */
 
 
@@ -26,639 +24,943 @@
 
 
 /* global variables */
-FILE* pFile;
 char* pFilename = NULL;
-pcg32_random_t pcg32_random;
 
 
 int main(int iArgCount, char* aArgV[]) {
 
+	/* set global variable for thread functions */
+	pFilename = aArgV[0];
+
 	/* arguments check */
-	if (iArgCount < 3) {
-		menu(aArgV[0]);
+	if (iArgCount < 2) {
+		menu(pFilename);
 		return EXIT_FAILURE;
 	}
 
-	/* initial variables */
-	int iAll = strcmp(aArgV[1], "-a");
-	int iSingleChar = strcmp(aArgV[1], "-f");
-	int iRestricted = strcmp(aArgV[1], "-r");
-	int iCrypto = strcmp(aArgV[1], "-c");
-	unsigned int iNumThreads = 1;
+	Options_t options;
 
-	/* set global variable for thread functions */
-	pFilename = aArgV[0];
-
-	if (iAll != 0 && iSingleChar != 0 && iRestricted != 0 && iCrypto != 0) {
-		menu(pFilename);
+	if (parseOptions(iArgCount, aArgV, &options) != 0) {
 		return EXIT_FAILURE;
 	}
 
-	/* create seed for rand() usage */
-	srand((unsigned int) time(NULL));
+	if (options.iTune) {
+		return tune(&options);
+	}
 
-	/* create seed for pcg_random() usage */
-	seed_pcg_random();
+	if (options.iAnalyze) {
+		return analyze(&options);
+	}
 
-	/* main variables */
+	if (options.iSelfTest) {
+		return selfTest(&options);
+	}
 
-	/* detect number of CPU threads (logical cores, not physical cores, Intel i3 = 4: 2 cores + 2 threads) */
-	#ifdef __linux
-		iNumThreads = (unsigned int) get_nprocs();
-		pthread_t rThreadID[iNumThreads];
-	#elif _WIN64
-		DWORD dwThreadID;
-		SYSTEM_INFO siSysInfo;
-		GetSystemInfo(&siSysInfo);
-		iNumThreads = (unsigned int) siSysInfo.dwNumberOfProcessors;
-		HANDLE rThreadID[iNumThreads];
-	#endif
+	if (options.iSinkNone) {
+		return stress(&options);
+	}
 
-	int iSizeLen = strlen(aArgV[2]);
-	int64_t iNegCheck = 0;
+	if (options.sOverwrite != NULL) {
+		return overwrite(&options);
+	}
 
-	unsigned int iFIndex = 0;
-	uint64_t iTotalBytes = 0;
-	uint64_t iThreadBytes = 0;
+	if (options.fMutate > 0) {
+		return mutate(&options);
+	}
 
-	char cUnit;
-	char sFileSize[iSizeLen];
+	if (options.iTar) {
+		return tarStream(&options);
+	}
 
-	clock_t tStart = 0;
+	if (options.sTree != NULL) {
+		return createTree(&options);
+	}
 
-	/* function pointers */
-	void (*pFuncs[4]) = {
-		generateAll,
-		generateSingleChar,
-		generateRestricted,
-		generateCrypto
-	};
+	if (options.sTcp != NULL || options.sUdp != NULL) {
+		return netSend(&options);
+	}
 
-	/* get size character */
-	cUnit = aArgV[2][iSizeLen - 1];
-	cUnit = tolower(cUnit);
+	if (options.iCount > 0) {
+		return fanOut(&options);
+	}
 
-	/* check size character */
-	if (cUnit != 'k' && cUnit != 'm' && cUnit != 'g') {
-		fprintf(stderr, "\n%s: please specify the file/stream size with a suffix of k, m, or g\n\n", pFilename);
-		return EXIT_FAILURE;
+	if (options.iRandomOrder) {
+		return randomWrite(&options);
 	}
 
-	/* substring size */
-	strncpy(sFileSize, aArgV[2], iSizeLen - 1);
-	sFileSize[iSizeLen - 1] = '\0';
+	#ifdef __linux
 
-	/* check for negative size */
-	iNegCheck = strtol(sFileSize, (char**) NULL, 10);
+		/* ordered output stage: file or stream, any thread count */
+		return streamOut(&options);
 
-	if (iNegCheck < 0) {
-		fprintf(stderr, "\n%s: negative size attempted! Please use a positive number and size suffix of k, m, or g for <size>  e.g. 100k\n\n", pFilename);
-		return EXIT_FAILURE;
-	}
+	#elif _WIN64
 
-	/* convert size to unsigned 64-bit */
-	iTotalBytes = strtoull(sFileSize, (char**) NULL, 10);
+		/* main variables */
+		unsigned int iNumThreads = options.iThreads;
 
-	/* check for zero output */
-	if (iTotalBytes == 0) {
-		fprintf(stderr, "\n%s: zero-sized output! Please use a number and size suffix of k, m, or g for <size>  e.g. 100k\n\n", pFilename);
-		return EXIT_FAILURE;
-	}
+		DWORD dwThreadID;
+		HANDLE rThreadID[iNumThreads];
 
-	/* convert unit to bytes */
-	if (cUnit == 'k') {
-		iTotalBytes = 1024 * iTotalBytes;
-	}
-	else if (cUnit == 'm') {
-		iTotalBytes = 1024 * 1024 * iTotalBytes;
-	}
-	else if (cUnit == 'g') {
-		iTotalBytes = 1024 * 1024 * 1024 * iTotalBytes;
-	}
-	else {
-		fprintf(stderr, "\n%s: file size error!\n\n", pFilename);
-		return EXIT_FAILURE;
-	}
+		uint64_t iTotalBytes = options.iBytes;
+		uint64_t iThreadBytes = 0;
 
-	/* total bytes divided by threads */
-	iThreadBytes = iTotalBytes / iNumThreads;
+		FILE* pOut = NULL;
+		rnd64_ctx_t* pCtx = NULL;
+		Arena_t* pArena = NULL;
+		Params_t aParams[iNumThreads];
 
-	Params_t params;
-	params.bytes = iThreadBytes;
+		clock_t tStart = 0;
 
-	if (aArgV[3] == NULL) {
-		params.filename = NULL;
-	}
-	else {
+		pCtx = rnd64_create(options.iMode, options.iEngine, options.iSeed);
 
-		params.filename = aArgV[3];
-		pFile = fopen(aArgV[3], "wb");
+		if (pCtx == NULL) {
+			fprintf(stderr, "\n%s: secure data generation unavailable.\n\n", pFilename);
+			return EXIT_FAILURE;
+		}
 
-		if (pFile == NULL) {
-			fprintf(stderr, "\n%s: output file cannot be written.\n(check write permissions / filename characters)\n\n", pFilename);
+		/* one buffer per thread, allocated up front */
+		pArena = arenaCreate(options.iBuffer, iNumThreads);
+
+		if (pArena == NULL) {
+			fprintf(stderr, "\n%s: insufficient memory for %u buffers of %u bytes.\n\n", pFilename, iNumThreads, options.iBuffer);
+			rnd64_destroy(pCtx);
 			return EXIT_FAILURE;
 		}
-	}
 
-	/* timer start */
-	tStart = clock();
+		if (options.sOutput != NULL) {
 
-	/* set function pointer index */
-	if (iAll == 0) {
-		iFIndex = 0;
-	}
-	else if (iSingleChar == 0) {
-		iFIndex = 1;
-	}
-	else if (iRestricted == 0) {
-		iFIndex = 2;
-	}
-	else if (iCrypto == 0) {
-		iFIndex = 3;
-	}
+			/* create or truncate, then each thread opens its own handle below */
+			pOut = fopen(options.sOutput, "wb");
 
-	/* pass params to thread function */
-	for (unsigned int i = 0; i < iNumThreads; i++) {
+			if (pOut == NULL) {
+				fprintf(stderr, "\n%s: output file cannot be written.\n(check write permissions / filename characters)\n\n", pFilename);
+				arenaDestroy(pArena);
+				rnd64_destroy(pCtx);
+				return EXIT_FAILURE;
+			}
 
-		#ifdef __linux
-			pthread_create(&rThreadID[i], NULL, pFuncs[iFIndex], &params);
-		#elif _WIN64
-			rThreadID[i] = CreateThread(NULL, 0, pFuncs[iFIndex], &params, 0, &dwThreadID);
-		#endif
-	}
+			fclose(pOut);
+		}
+		else if (options.iSeed != 0) {
 
-	/* thread wait and join */
-	for (unsigned int i = 0; i < iNumThreads; i++) {
+			/* sections written to one stream interleave, so a seeded stream uses one thread to stay in order */
+			iNumThreads = 1;
+		}
 
-		#ifdef __linux
-			pthread_join(rThreadID[i], NULL);
-		#elif _WIN64
-			WaitForSingleObject(rThreadID[i], INFINITE);
-		#endif
-	}
+		/* total bytes divided by threads, remainder to the last thread */
+		iThreadBytes = iTotalBytes / iNumThreads;
 
-	if (params.filename != NULL || STREAM_STATS) { /* file output or STREAM_STATS */
+		/* each thread generates its own section of one stream, file sections are written at their own offsets */
+		for (unsigned int i = 0; i < iNumThreads; i++) {
 
-		int iMSec = 0;
-		clock_t tDiff = 0;
+			aParams[i].pOut = (options.sOutput != NULL) ? openSection(options.sOutput, i * iThreadBytes) : stdout;
+			aParams[i].bytes = (i == iNumThreads - 1) ? iTotalBytes - i * iThreadBytes : iThreadBytes;
+			aParams[i].iBuffer = options.iBuffer;
+			aParams[i].pArena = pArena;
+			aParams[i].pCtx = rnd64_clone(pCtx);
 
-		if (params.filename != NULL) {
-			fclose(pFile);
-			printf("\n%s generated\n\nsize: %"PRId64" bytes\n", aArgV[3], iTotalBytes);
-		}
+			if (aParams[i].pOut == NULL || aParams[i].pCtx == NULL) {
 
-		/* timer end */
-		tDiff = clock() - tStart;
+				if (aParams[i].pOut == NULL) {
+					fprintf(stderr, "\n%s: output file cannot be written.\n(check write permissions / filename characters)\n\n", pFilename);
+				}
+				else {
+					fprintf(stderr, "\n%s: generator initialisation failed.\n\n", pFilename);
+				}
+
+				/* release every section opened so far */
+				for (unsigned int j = 0; j <= i; j++) {
+
+					if (options.sOutput != NULL && aParams[j].pOut != NULL) {
+						fclose(aParams[j].pOut);
+					}
 
-		/* timer display, by Ben Alpert */
-		iMSec = tDiff * 1000 / CLOCKS_PER_SEC;
+					rnd64_destroy(aParams[j].pCtx);
+				}
+
+				arenaDestroy(pArena);
+				rnd64_destroy(pCtx);
+				return EXIT_FAILURE;
+			}
 
-		if (STREAM_STATS) {
-			fprintf(stderr, "time: %d s %d ms\n", iMSec / 1000, iMSec % 1000);
+			rnd64_seek(aParams[i].pCtx, i * iThreadBytes);
 		}
-		else {
-			printf("time: %d s %d ms\n", iMSec / 1000, iMSec % 1000);
+
+		/* timer start */
+		tStart = clock();
+
+		/* pass params to thread function */
+		for (unsigned int i = 0; i < iNumThreads; i++) {
+			rThreadID[i] = CreateThread(NULL, 0, generateStream, &aParams[i], 0, &dwThreadID);
 		}
 
-		/* MB/s calculation for size over 50MB */
-		if (iTotalBytes > 52428800) {
+		/* thread wait and join */
+		for (unsigned int i = 0; i < iNumThreads; i++) {
+
+			WaitForSingleObject(rThreadID[i], INFINITE);
+
+			rnd64_destroy(aParams[i].pCtx);
+
+			if (options.sOutput != NULL) {
+				fclose(aParams[i].pOut);
+			}
+		}
+
+		rnd64_destroy(pCtx);
+		arenaDestroy(pArena);
+
+		if (options.sOutput != NULL || STREAM_STATS) { /* file output or STREAM_STATS */
+
+			int iMSec = 0;
+			clock_t tDiff = 0;
+
+			if (options.sOutput != NULL) {
+				printf("\n%s generated\n\nsize: %"PRId64" bytes\n", options.sOutput, iTotalBytes);
+			}
+
+			/* timer end */
+			tDiff = clock() - tStart;
+
+			/* timer display, by Ben Alpert */
+			iMSec = tDiff * 1000 / CLOCKS_PER_SEC;
 
 			if (STREAM_STATS) {
-				fprintf(stderr, "MB/s: %0.2f\n", (float) ((iTotalBytes * cMBRECIP * cMBRECIP) / (iMSec * 0.001)));
+				fprintf(stderr, "time: %d s %d ms\n", iMSec / 1000, iMSec % 1000);
 			}
 			else {
-				printf("MB/s: %0.2f\n", (float) ((iTotalBytes * cMBRECIP * cMBRECIP) / (iMSec * 0.001)));
+				printf("time: %d s %d ms\n", iMSec / 1000, iMSec % 1000);
 			}
+
+			/* MB/s calculation for size over 50MB */
+			if (iTotalBytes > 52428800) {
+
+				if (STREAM_STATS) {
+					fprintf(stderr, "MB/s: %0.2f\n", (float) ((iTotalBytes * cMBRECIP * cMBRECIP) / (iMSec * 0.001)));
+				}
+				else {
+					printf("MB/s: %0.2f\n", (float) ((iTotalBytes * cMBRECIP * cMBRECIP) / (iMSec * 0.001)));
+				}
+			}
+
+			printf("\n");
 		}
 
-		printf("\n");
-	}
+		return EXIT_SUCCESS;
 
-	return EXIT_SUCCESS;
+	#endif
 }
 
 
 /**
-	* Seed the pcg_random generator.
+	* Parse command-line options and positional <size> [file] arguments.
 	*
-	* @param   void
-	* @return  void
+	* @param   int iArgCount
+	* @param   char* aArgV[]
+	* @param   Options_t* pOptions, populated
+	* @return  int, 0 on success, -1 on error (message printed)
 */
 
-void seed_pcg_random(void) {
+int parseOptions(int iArgCount, char* aArgV[], Options_t* pOptions) {
+
+	enum { OPT_COUNT = 256, OPT_SIZE, OPT_PATTERN, OPT_OPEN, OPT_TREE, OPT_FANOUT, OPT_DEPTH, OPT_SIZE_DIST, OPT_TCP, OPT_UDP, OPT_ZEROCOPY, OPT_ISA, OPT_TUNE, OPT_ANALYZE, OPT_SELFTEST, OPT_SINK, OPT_DURATION, OPT_MEMSTRESS, OPT_OVERWRITE, OPT_PASSES, OPT_DISCARD, OPT_QD, OPT_ORDER, OPT_BLOCK, OPT_MUTATE, OPT_OPS, OPT_MANIFEST, OPT_TAR };
+
+	static struct option const aLongOpts[] = {
+		{"threads", required_argument, NULL, 't'},
+		{"seed",    required_argument, NULL, 's'},
+		{"count",   required_argument, NULL, OPT_COUNT},
+		{"size",    required_argument, NULL, OPT_SIZE},
+		{"pattern", required_argument, NULL, OPT_PATTERN},
+		{"open",    required_argument, NULL, OPT_OPEN},
+		{"tree",    required_argument, NULL, OPT_TREE},
+		{"fanout",  required_argument, NULL, OPT_FANOUT},
+		{"depth",   required_argument, NULL, OPT_DEPTH},
+		{"size-dist", required_argument, NULL, OPT_SIZE_DIST},
+		{"tcp",     required_argument, NULL, OPT_TCP},
+		{"udp",     required_argument, NULL, OPT_UDP},
+		{"zerocopy", no_argument,      NULL, OPT_ZEROCOPY},
+		{"isa",     required_argument, NULL, OPT_ISA},
+		{"tune",    no_argument,       NULL, OPT_TUNE},
+		{"analyze", no_argument,       NULL, OPT_ANALYZE},
+		{"selftest", no_argument,      NULL, OPT_SELFTEST},
+		{"sink",    required_argument, NULL, OPT_SINK},
+		{"duration", required_argument, NULL, OPT_DURATION},
+		{"memstress", required_argument, NULL, OPT_MEMSTRESS},
+		{"overwrite", required_argument, NULL, OPT_OVERWRITE},
+		{"passes",  required_argument, NULL, OPT_PASSES},
+		{"discard", no_argument,       NULL, OPT_DISCARD},
+		{"qd",      required_argument, NULL, OPT_QD},
+		{"order",   required_argument, NULL, OPT_ORDER},
+		{"block",   required_argument, NULL, OPT_BLOCK},
+		{"mutate",  required_argument, NULL, OPT_MUTATE},
+		{"ops",     required_argument, NULL, OPT_OPS},
+		{"manifest", required_argument, NULL, OPT_MANIFEST},
+		{"tar",     no_argument,       NULL, OPT_TAR},
+		{NULL, 0, NULL, 0}
+	};
 
-	/* set state */
-	pcg32_random.state ^= (uint64_t) time(NULL) ^ (uint64_t) &seed_pcg_random;
+	int iOpt = 0;
+	int iModeSet = 0;
+	char* sSize = NULL;
+	char* sSizeDist = NULL;
+	char* pPercent = NULL;
+	char* pEnd = NULL;
+	unsigned long iDepth = 0;
+
+	memset(pOptions, 0, sizeof(Options_t));
+	pOptions->iMode = RND64_MODE_ALL;
+	pOptions->iEngine = RND64_ENGINE_PCG32;
+	pOptions->iFanout = 16;
+	pOptions->iDepth = 2;
+	pOptions->iBuffer = cBUFFER;
+
+	while ((iOpt = getopt_long(iArgCount, aArgV, "afrct:s:P:", aLongOpts, NULL)) != -1) {
+
+		switch (iOpt) {
+
+			case 'a':
+				pOptions->iMode = RND64_MODE_ALL;
+				iModeSet = 1;
+				break;
+
+			case 'f':
+				pOptions->iMode = RND64_MODE_SINGLE;
+				iModeSet = 1;
+				break;
+
+			case 'r':
+				pOptions->iMode = RND64_MODE_RESTRICTED;
+				iModeSet = 1;
+				break;
+
+			case 'c':
+				pOptions->iEngine = RND64_ENGINE_CRYPTO;
+				iModeSet = 1;
+				break;
+
+			case 't':
+				if (parseCount(optarg, "-t", cTHREADS_MAX, &pOptions->iThreads) != 0) {
+					return -1;
+				}
+				break;
 
-	/* generate 12 ints for initial state to diverge */
-	for (unsigned int i = 0; i < 12; i++) {
-		pcg32_random_r(&pcg32_random);
-	}
-}
+			case 's':
+				pOptions->iSeed = strtoull(optarg, NULL, 0);
+				break;
 
+			case OPT_COUNT:
+				pOptions->iCount = strtoull(optarg, NULL, 10);
+				break;
 
-/**
-	* pcg32_random fast random number generator (minimal PCG32 version)
-	* (c) 2014 Professor Melissa E. O'Neill - pcg-random.org
-	* Apache License 2.0
-	*
-	* @param   pcg32_random_t* rng
-	* @return  uint32_t
-*/
+			case OPT_SIZE:
+				sSize = optarg;
+				break;
 
-inline uint32_t pcg32_random_r(pcg32_random_t* rng)
-{
-	uint64_t oldstate = rng->state;
+			case OPT_PATTERN:
+				pOptions->sPattern = optarg;
+				break;
 
-	/* advance internal state */
-	rng->state = oldstate * 6364136223846793005ULL + (rng->inc | 1);
+			case OPT_OPEN:
+				if (parseCount(optarg, "--open", cOPEN_MAX, &pOptions->iOpen) != 0) {
+					return -1;
+				}
+				break;
 
-	/* calculate output function (XSH RR), uses old state for max ILP */
-	uint32_t xorshifted = ((oldstate >> 18u) ^ oldstate) >> 27u;
-	uint32_t rot = oldstate >> 59u;
+			case OPT_TREE:
+				pOptions->sTree = optarg;
+				break;
 
-	return (xorshifted >> rot) | (xorshifted << ((-rot) & 31));
-}
+			case OPT_FANOUT:
+				if (parseCount(optarg, "--fanout", cFANOUT_MAX, &pOptions->iFanout) != 0) {
+					return -1;
+				}
+				break;
 
+			case OPT_DEPTH:
+				/* 0: files in the root directory */
+				iDepth = strtoul(optarg, &pEnd, 10);
 
-/**
-	* Thread function: output random uints using pcg_random.
-	*
-	* @param   void pointer st, params struct
-	* @return  void* / null
-*/
+				if (pEnd == optarg || *pEnd != '\0' || optarg[0] == '-' || iDepth > cDEPTH_MAX) {
+					fprintf(stderr, "\n%s: --depth takes a number from 0 to %u\n\n", pFilename, cDEPTH_MAX);
+					return -1;
+				}
 
-#ifdef __linux
-	void* generateAll(void* st)
-#elif _WIN64
-	DWORD WINAPI generateAll(LPVOID st)
-#endif
+				pOptions->iDepth = (unsigned int) iDepth;
+				break;
+
+			case OPT_SIZE_DIST:
+				sSizeDist = optarg;
+				break;
 
-	{
-		Params_t* params = (Params_t*) st;
-		uint64_t iThreadBytes = params->bytes;
+			case OPT_TCP:
+				pOptions->sTcp = optarg;
+				break;
 
-		unsigned int iNumPages = iThreadBytes / cBUFFER;
-		unsigned int iNumBytes = cBUFFER / sizeof(unsigned int);
-		unsigned int iTailSize = iThreadBytes % cBUFFER;
-		uint32_t aBuffer[cBUFFER];
+			case OPT_UDP:
+				pOptions->sUdp = optarg;
+				break;
 
-		if (params->filename != NULL) { /* write to file */
+			case 'P':
+				if (parseCount(optarg, "-P", cSTREAMS_MAX, &pOptions->iStreams) != 0) {
+					return -1;
+				}
+				break;
 
-			for (unsigned int i = 0; i < iNumPages; i++) {
+			case OPT_ZEROCOPY:
+				pOptions->iZeroCopy = 1;
+				break;
 
-				for (unsigned int j = 0; j < iNumBytes; j++) {
-					aBuffer[j] = pcg32_random_r(&pcg32_random);
+			case OPT_ISA:
+				if (rnd64_set_isa(optarg) != 0) {
+					fprintf(stderr, "\n%s: --isa '%s' is unknown or not supported by this CPU (auto, scalar, sse2, avx2, avx512).\n\n", pFilename, optarg);
+					return -1;
 				}
+				break;
 
-				fwrite(aBuffer, 1, cBUFFER, pFile);
-			}
+			case OPT_TUNE:
+				pOptions->iTune = 1;
+				break;
+
+			case OPT_ANALYZE:
+				pOptions->iAnalyze = 1;
+				break;
 
-			if (iTailSize > 0) {
+			case OPT_SELFTEST:
+				pOptions->iSelfTest = 1;
+				break;
 
-				for (unsigned int j = 0; j < iNumBytes; j++) {
-					aBuffer[j] = pcg32_random_r(&pcg32_random);
+			case OPT_SINK:
+				if (strcmp(optarg, "none") != 0) {
+					fprintf(stderr, "\n%s: --sink takes 'none' (generate without output)\n\n", pFilename);
+					return -1;
 				}
+				pOptions->iSinkNone = 1;
+				break;
 
-				fwrite(aBuffer, 1, iTailSize, pFile);
-			}
-		}
-		else { /* write to stdout */
+			case OPT_DURATION:
+				if (parseDuration(optarg, &pOptions->iDuration) != 0) {
+					return -1;
+				}
+				break;
+
+			case OPT_MEMSTRESS:
+				if (parseSize(optarg, &pOptions->iMemStress) != 0) {
+					return -1;
+				}
+				pOptions->iSinkNone = 1;
+				break;
+
+			case OPT_OVERWRITE:
+				pOptions->sOverwrite = optarg;
+				break;
 
-			for (unsigned int i = 0; i < iNumPages; i++) {
+			case OPT_PASSES:
+				pOptions->sPasses = optarg;
+				break;
 
-				for (unsigned int j = 0; j < iNumBytes; j++) {
-					aBuffer[j] = pcg32_random_r(&pcg32_random);
+			case OPT_DISCARD:
+				pOptions->iDiscard = 1;
+				break;
+
+			case OPT_QD:
+				if (parseCount(optarg, "--qd", cQUEUE_MAX, &pOptions->iQueueDepth) != 0) {
+					return -1;
 				}
+				break;
 
-				fwrite(aBuffer, 1, cBUFFER, stdout);
-			}
+			case OPT_ORDER:
+				if (strcmp(optarg, "random") == 0) {
+					pOptions->iRandomOrder = 1;
+				}
+				else if (strcmp(optarg, "sequential") != 0) {
+					fprintf(stderr, "\n%s: --order takes 'sequential' (default) or 'random'\n\n", pFilename);
+					return -1;
+				}
+				break;
 
-			if (iTailSize > 0) {
+			case OPT_BLOCK:
+				if (parseSize(optarg, &pOptions->iBlock) != 0) {
+					return -1;
+				}
+				if (pOptions->iBlock > cBLOCK_MAX) {
+					fprintf(stderr, "\n%s: --block is limited to %uk\n\n", pFilename, (unsigned int) (cBLOCK_MAX / KB));
+					return -1;
+				}
+				break;
 
-				for (unsigned int j = 0; j < iNumBytes; j++) {
-					aBuffer[j] = pcg32_random_r(&pcg32_random);
+			case OPT_MUTATE:
+				pOptions->fMutate = strtod(optarg, &pPercent);
+				if (pPercent == optarg || (*pPercent != '\0' && strcmp(pPercent, "%") != 0) || ! (pOptions->fMutate > 0 && pOptions->fMutate <= 100)) {
+					fprintf(stderr, "\n%s: --mutate takes a percentage of the file's blocks, e.g. 2%% or 0.5%%\n\n", pFilename);
+					return -1;
 				}
+				break;
 
-				fwrite(aBuffer, 1, iTailSize, stdout);
-			}
+			case OPT_OPS:
+				pOptions->sOps = optarg;
+				break;
+
+			case OPT_MANIFEST:
+				pOptions->sManifest = optarg;
+				break;
+
+			case OPT_TAR:
+				pOptions->iTar = 1;
+				break;
+
+			default:
+				menu(pFilename);
+				return -1;
 		}
+	}
 
-#ifdef __linux
-		pthread_exit(NULL);
-#elif _WIN64
-		return 0;
-#endif
+	/* consumer: no generator mode or size */
+	if (pOptions->iAnalyze) {
+
+		if (optind < iArgCount) {
+			pOptions->sInput = aArgV[optind++];
+		}
 
+		if (pOptions->iThreads == 0) {
+			pOptions->iThreads = rnd64_cpu_count();
+		}
+
+		return 0;
 	}
 
+	/* self-test: optional [size] per engine, default 1 GB */
+	if (pOptions->iSelfTest) {
 
-/**
-	* Thread function: output printable ASCII characters (33 to 127).
-	* Not fast, included to generate printable characters for my purposes.
-	*
-	* @param   void pointer st, params struct
-	* @return  void* / null
-*/
+		if (sSize == NULL && optind < iArgCount) {
+			sSize = aArgV[optind++];
+		}
 
-#ifdef __linux
-	void* generateRestricted(void* st)
-#elif _WIN64
-	DWORD WINAPI generateRestricted(LPVOID st)
-#endif
+		if (sSize == NULL) {
+			pOptions->iBytes = 1024 * KB * KB;
+		}
+		else if (parseSize(sSize, &pOptions->iBytes) != 0) {
+			return -1;
+		}
 
-	{
-		Params_t* params = (Params_t*) st;
-		uint64_t iThreadBytes = params->bytes;
+		if (iModeSet) {
 
-		unsigned int iNumPages = iThreadBytes / cBUFFER;
-		unsigned int iNumBytes = cBUFFER / sizeof(char); /* sizeof(char) slow; hack: sizeof(unsigned int) faster but corrupted buffer */
-		unsigned int iTailSize = iThreadBytes % cBUFFER;
-		char aBuffer[cBUFFER];
+			if (pOptions->iMode == RND64_MODE_SINGLE || (pOptions->iEngine == RND64_ENGINE_CRYPTO && pOptions->iMode != RND64_MODE_ALL)) {
+				fprintf(stderr, "\n%s: --selftest tests one of -a, -r or -c, or all three\n\n", pFilename);
+				return -1;
+			}
 
-		#ifdef __linux
-			unsigned int iSeed = 0;
-			iSeed = rand();
-		#elif _WIN64
-			static unsigned int iSeed = 3142;
-			iSeed += (((unsigned int) time(NULL)) * 0.2);
-			srand(iSeed);
-		#endif
+			pOptions->iSelfTest = 2;
+		}
 
-		if (params->filename != NULL) { /* write to file */
+		if (pOptions->iThreads == 0) {
+			pOptions->iThreads = rnd64_cpu_count();
+		}
 
-			for (unsigned int i = 0; i < iNumPages; i++) {
+		return 0;
+	}
 
-				for (unsigned int j = 0; j < iNumBytes; j++) {
+	/* in place: the size is the target's; random passes are -a (default) or -c */
+	if (pOptions->sOverwrite != NULL) {
 
-					#ifdef __linux
-						aBuffer[j] = (rand_r(&iSeed) % 94) + 33;
-					#elif _WIN64
-						aBuffer[j] = (rand() % 94) + 33;
-					#endif
-				}
+		if (pOptions->iMode != RND64_MODE_ALL) {
+			fprintf(stderr, "\n%s: --overwrite random passes use -a (default) or -c\n\n", pFilename);
+			return -1;
+		}
 
-				fwrite(aBuffer, 1, cBUFFER, pFile);
-			}
+		return 0;
+	}
 
-			if (iTailSize > 0) {
+	/* in place: the size is the file's */
+	if (pOptions->fMutate > 0) {
 
-				for (unsigned int j = 0; j < iNumBytes; j++) {
+		if (optind < iArgCount) {
+			pOptions->sOutput = aArgV[optind++];
+		}
 
-					#ifdef __linux
-						aBuffer[j] = (rand_r(&iSeed) % 94) + 33;
-					#elif _WIN64
-						aBuffer[j] = (rand() % 94) + 33;
-					#endif
-				}
+		if (pOptions->sOutput == NULL) {
+			fprintf(stderr, "\n%s: --mutate changes an existing [file]\n\n", pFilename);
+			return -1;
+		}
 
-				fwrite(aBuffer, 1, iTailSize, pFile);
-			}
+		if (pOptions->iBlock == 0) {
+			pOptions->iBlock = 4 * KB;
 		}
-		else { /* write to stdout */
 
-			for (unsigned int i = 0; i < iNumPages; i++) {
+		return 0;
+	}
 
-				for (unsigned int j = 0; j < iNumBytes; j++) {
+	if ( ! iModeSet) {
+		menu(pFilename);
+		return -1;
+	}
 
-					#ifdef __linux
-						aBuffer[j] = (rand_r(&iSeed) % 94) + 33;
-					#elif _WIN64
-						aBuffer[j] = (rand() % 94) + 33;
-					#endif
-				}
+	/* positional arguments: <size> [file] */
+	if (sSize == NULL && sSizeDist == NULL && optind < iArgCount) {
+		sSize = aArgV[optind++];
+	}
 
-				fwrite(aBuffer, 1, cBUFFER, stdout);
-			}
+	if (optind < iArgCount) {
+		pOptions->sOutput = aArgV[optind++];
+	}
 
-			if (iTailSize > 0) {
+	if (pOptions->iTune) {
+		return 0;
+	}
 
-				for (unsigned int j = 0; j < iNumBytes; j++) {
+	if (pOptions->iDuration > 0 && ! pOptions->iSinkNone) {
+		fprintf(stderr, "\n%s: --duration requires --sink=none\n\n", pFilename);
+		return -1;
+	}
 
-					#ifdef __linux
-						aBuffer[j] = (rand_r(&iSeed) % 94) + 33;
-					#elif _WIN64
-						aBuffer[j] = (rand() % 94) + 33;
-					#endif
-				}
+	if (pOptions->iSinkNone && pOptions->sOutput != NULL) {
+		fprintf(stderr, "\n%s: --sink=none writes no [file]\n\n", pFilename);
+		return -1;
+	}
 
-				fwrite(aBuffer, 1, iTailSize, stdout);
-			}
+	if (sSizeDist != NULL) {
+
+		char* pColon = strchr(sSizeDist, ':');
+
+		if (pColon == NULL) {
+			fprintf(stderr, "\n%s: --size-dist takes MIN:MAX  e.g. 4k:1m\n\n", pFilename);
+			return -1;
 		}
 
-#ifdef __linux
-		pthread_exit(NULL);
-#elif _WIN64
-		return 0;
-#endif
+		*pColon = '\0';
 
+		if (parseSize(sSizeDist, &pOptions->iSizeMin) != 0 || parseSize(pColon + 1, &pOptions->iSizeMax) != 0) {
+			return -1;
+		}
+
+		if (pOptions->iSizeMin > pOptions->iSizeMax) {
+			fprintf(stderr, "\n%s: --size-dist MIN is larger than MAX\n\n", pFilename);
+			return -1;
+		}
+
+		pOptions->iBytes = pOptions->iSizeMax;
+	}
+	else if (sSize == NULL && pOptions->iDuration > 0) {
+		/* timed: no <size> */
+	}
+	else if (sSize == NULL) {
+		menu(pFilename);
+		return -1;
+	}
+	else if (parseSize(sSize, &pOptions->iBytes) != 0) {
+		return -1;
+	}
+	else {
+		pOptions->iSizeMin = pOptions->iSizeMax = pOptions->iBytes;
 	}
 
+	loadProfile(pOptions);
 
-/**
-	* Thread function: output null character.
-	*
-	* @param   void pointer st, params struct
-	* @return  void* / null
-*/
+	if (pOptions->iThreads == 0) {
+		pOptions->iThreads = rnd64_cpu_count();
+	}
 
-#ifdef __linux
-	void* generateSingleChar(void* st)
-#elif _WIN64
-	DWORD WINAPI generateSingleChar(LPVOID st)
-#endif
+	if (pOptions->iStreams == 0) {
+		pOptions->iStreams = 1;
+	}
 
-	{
-		Params_t* params = (Params_t*) st;
-		uint64_t iThreadBytes = params->bytes;
+	if (pOptions->sTcp != NULL && pOptions->sUdp != NULL) {
+		fprintf(stderr, "\n%s: use one of --tcp or --udp\n\n", pFilename);
+		return -1;
+	}
 
-		unsigned int iNumPages = iThreadBytes / cBUFFER;
-		unsigned int iNumBytes = cBUFFER / sizeof(unsigned int);
-		unsigned int iTailSize = iThreadBytes % cBUFFER;
-		unsigned int aBuffer[cBUFFER]; /* slightly faster (just) in using array on stack rather than heap (malloc); int_fast8_t tried */
+	if (pOptions->iTar) {
 
-		if (params->filename != NULL) { /* write to file */
+		if (pOptions->iCount == 0 || pOptions->sTree != NULL) {
+			fprintf(stderr, "\n%s: --tar requires --count <files>, and replaces --tree\n\n", pFilename);
+			return -1;
+		}
+	}
+	else if (pOptions->sTree != NULL) {
 
-			for (unsigned int i = 0; i < iNumPages; i++) {
-				memset(aBuffer, cNB, iNumBytes);
-				fwrite(aBuffer, 1, cBUFFER, pFile);
-			}
+		if (pOptions->iCount == 0) {
+			fprintf(stderr, "\n%s: --tree requires --count <files>\n\n", pFilename);
+			return -1;
+		}
+	}
+
+	if (pOptions->iTar || pOptions->sTree != NULL) {
+
+		uint64_t iLeaves = 1;
+
+		for (unsigned int k = 0; k < pOptions->iDepth; k++) {
+
+			iLeaves *= pOptions->iFanout;
 
-			if (iTailSize > 0) {
-				memset(aBuffer, cNB, iNumBytes);
-				fwrite(aBuffer, 1, iTailSize, pFile);
+			if (iLeaves > cLEAVES_MAX) {
+				fprintf(stderr, "\n%s: --fanout %u with --depth %u exceeds %"PRIu64" leaf directories\n\n", pFilename, pOptions->iFanout, pOptions->iDepth, cLEAVES_MAX);
+				return -1;
 			}
 		}
-		else { /* write to stdout */
+	}
+	else if (pOptions->iCount > 0) {
 
-			for (unsigned int i = 0; i < iNumPages; i++) {
-				memset(aBuffer, cNB, iNumBytes);
-				fwrite(aBuffer, 1, cBUFFER, stdout);
-			}
+		if (sSizeDist != NULL) {
+			fprintf(stderr, "\n%s: --size-dist applies to --tree and --tar: --count files are all <size>\n\n", pFilename);
+			return -1;
+		}
 
-			if (iTailSize > 0) {
-				memset(aBuffer, cNB, iNumBytes);
-				fwrite(aBuffer, 1, iTailSize, stdout);
-			}
+		if (pOptions->sPattern == NULL) {
+			pOptions->sPattern = pOptions->sOutput;
 		}
 
-#ifdef __linux
-		pthread_exit(NULL);
-#elif _WIN64
-		return 0;
-#endif
+		if (pOptions->sPattern == NULL) {
+			fprintf(stderr, "\n%s: --count requires a filename --pattern  e.g. data_%%04d.bin\n\n", pFilename);
+			return -1;
+		}
+
+		if (pOptions->iOpen == 0) {
+			pOptions->iOpen = pOptions->iThreads;
+		}
+	}
 
+	if (pOptions->iRandomOrder) {
+
+		if (pOptions->sOutput == NULL || pOptions->iCount > 0 || pOptions->sTcp != NULL || pOptions->sUdp != NULL) {
+			fprintf(stderr, "\n%s: --order random writes one [file]\n\n", pFilename);
+			return -1;
+		}
+
+		if (pOptions->iBlock == 0) {
+			pOptions->iBlock = 4 * KB;
+		}
 	}
 
+	return 0;
+}
+
 
 /**
-	* Thread function: output crypto-generated bytes.
+	* Convert a size with a k, m, or g suffix to bytes.
 	*
-	* @param   void pointer st, params struct
-	* @return  void* / null
+	* @param   char* sSize, e.g. 100k
+	* @param   uint64_t* pBytes, result
+	* @return  int, 0 on success, -1 on error (message printed)
 */
 
-#ifdef __linux
+int parseSize(char const* sSize, uint64_t* pBytes) {
 
-	void* generateCrypto(void* st) {
+	size_t iSizeLen = strlen(sSize);
+	int64_t iNegCheck = 0;
+	uint64_t iBytes = 0;
 
-		Params_t* params = (Params_t*) st;
-		uint64_t iThreadBytes = params->bytes;
+	char cUnit;
+	char sFileSize[iSizeLen + 1];
 
-		unsigned int iNumPages = iThreadBytes / cBUFFER;
-		unsigned int iNumBytes = cBUFFER / sizeof(char);
-		unsigned int iTailSize = iThreadBytes % cBUFFER;
-		unsigned int aBuffer[cBUFFER];
-		FILE* pUrand;
+	if (iSizeLen < 2) {
+		fprintf(stderr, "\n%s: please specify the file/stream size with a suffix of k, m, or g\n\n", pFilename);
+		return -1;
+	}
 
-		if ((pUrand = fopen(RANDOM_PATH, "r")) == NULL) {
-			fprintf(stderr, "\n%s: secure data generation unavailable.\n\n", pFilename);
-		}
-		else if (params->filename != NULL) { /* write to file */
+	/* get size character */
+	cUnit = sSize[iSizeLen - 1];
+	cUnit = tolower(cUnit);
 
-			for (unsigned int i = 0; i < iNumPages; i++) {
+	/* check size character */
+	if (cUnit != 'k' && cUnit != 'm' && cUnit != 'g') {
+		fprintf(stderr, "\n%s: please specify the file/stream size with a suffix of k, m, or g\n\n", pFilename);
+		return -1;
+	}
 
-				if (fread(aBuffer, 1, iNumBytes, pUrand) != iNumBytes) {
-					fprintf(stderr, "\n%s: insufficient crypto random bytes available.\n\n", pFilename);
-					goto exit;
-				}
+	/* substring size */
+	strncpy(sFileSize, sSize, iSizeLen - 1);
+	sFileSize[iSizeLen - 1] = '\0';
 
-				fwrite(aBuffer, 1, cBUFFER, pFile);
-			}
+	/* check for negative size */
+	iNegCheck = strtol(sFileSize, (char**) NULL, 10);
+
+	if (iNegCheck < 0) {
+		fprintf(stderr, "\n%s: negative size attempted! Please use a positive number and size suffix of k, m, or g for <size>  e.g. 100k\n\n", pFilename);
+		return -1;
+	}
 
-			if (iTailSize > 0) {
+	/* convert size to unsigned 64-bit */
+	iBytes = strtoull(sFileSize, (char**) NULL, 10);
 
-				if (fread(aBuffer, 1, iNumBytes, pUrand) != iNumBytes) {
-					fprintf(stderr, "\n%s: insufficient crypto random bytes available.\n\n", pFilename);
-					goto exit;
-				}
+	/* check for zero output */
+	if (iBytes == 0) {
+		fprintf(stderr, "\n%s: zero-sized output! Please use a number and size suffix of k, m, or g for <size>  e.g. 100k\n\n", pFilename);
+		return -1;
+	}
 
-				fwrite(aBuffer, 1, iTailSize, pFile);
-			}
-		}
-		else { /* write to stdout */
+	/* convert unit to bytes */
+	if (cUnit == 'k') {
+		iBytes = 1024 * iBytes;
+	}
+	else if (cUnit == 'm') {
+		iBytes = 1024 * 1024 * iBytes;
+	}
+	else {
+		iBytes = 1024 * 1024 * 1024 * iBytes;
+	}
 
-			for (unsigned int i = 0; i < iNumPages; i++) {
+	*pBytes = iBytes;
 
-				if (fread(aBuffer, 1, iNumBytes, pUrand) != iNumBytes) {
-					fprintf(stderr, "\n%s: insufficient crypto random bytes available.\n\n", pFilename);
-					goto exit;
-				}
+	return 0;
+}
 
-				fwrite(aBuffer, 1, cBUFFER, stdout);
-			}
 
-			if (iTailSize > 0) {
+/**
+	* Convert a duration with an optional s, m, h, or d suffix to seconds.
+	*
+	* @param   char* sDuration, e.g. 30m
+	* @param   uint64_t* pSeconds, result
+	* @return  int, 0 on success, -1 on error (message printed)
+*/
 
-				if (fread(aBuffer, 1, iNumBytes, pUrand) != iNumBytes) {
-					fprintf(stderr, "\n%s: insufficient crypto random bytes available.\n\n", pFilename);
-					goto exit;
-				}
+int parseDuration(char const* sDuration, uint64_t* pSeconds) {
 
-				fwrite(aBuffer, 1, iTailSize, stdout);
-			}
-		}
+	char* pEnd = NULL;
+	uint64_t iSeconds = 0;
 
-		exit:
+	if (isdigit((unsigned char) sDuration[0])) {
+		iSeconds = strtoull(sDuration, &pEnd, 10);
+	}
 
-			fclose(pUrand);
+	if (iSeconds == 0 || (pEnd[0] != '\0' && (strchr("smhd", tolower((unsigned char) pEnd[0])) == NULL || pEnd[1] != '\0'))) {
+		fprintf(stderr, "\n%s: please specify --duration with a suffix of s, m, h, or d  e.g. 30m\n\n", pFilename);
+		return -1;
+	}
 
-			pthread_exit(NULL);
+	switch (tolower((unsigned char) pEnd[0])) {
+		case 'm': iSeconds *= 60; break;
+		case 'h': iSeconds *= 3600; break;
+		case 'd': iSeconds *= 86400; break;
 	}
 
-#elif _WIN64
+	*pSeconds = iSeconds;
 
-	DWORD WINAPI generateCrypto(LPVOID st) {
+	return 0;
+}
 
-		Params_t* params = (Params_t*) st;
-		uint64_t iThreadBytes = params->bytes;
 
-		unsigned int iNumPages = iThreadBytes / cBUFFER;
-		unsigned int iNumBytes = cBUFFER / sizeof(char);
-		unsigned int iTailSize = iThreadBytes % cBUFFER;
-		HCRYPTPROV rCryptHandle = 0;
-		char aBuffer[cBUFFER];
-		char cS;
+/**
+	* Convert a count option (threads, open files, queue depth, connections) to a number from 1 to iMax.
+	*
+	* @param   char const* sCount, e.g. 8
+	* @param   char const* sOption, option name for the message
+	* @param   unsigned int iMax
+	* @param   unsigned int* pCount, result
+	* @return  int, 0 on success, -1 on error (message printed)
+*/
 
-		if (CryptAcquireContext(&rCryptHandle, NULL, NULL, PROV_RSA_FULL, CRYPT_VERIFYCONTEXT) == FALSE) {
-			fprintf(stderr, "\n%s: secure data generation unavailable (CryptAcquireContext failed).\n\n", pFilename);
-		}
-		else {
+int parseCount(char const* sCount, char const* sOption, unsigned int iMax, unsigned int* pCount) {
 
-			if (params->filename != NULL) { /* write to file */
+	char* pEnd = NULL;
+	unsigned long iCount = strtoul(sCount, &pEnd, 10);
 
-				for (unsigned int i = 0; i < iNumPages; i++) {
+	if (pEnd == sCount || *pEnd != '\0' || sCount[0] == '-' || iCount == 0 || iCount > iMax) {
+		fprintf(stderr, "\n%s: %s takes a number from 1 to %u\n\n", pFilename, sOption, iMax);
+		return -1;
+	}
 
-					for (unsigned int j = 0; j < iNumBytes; j++) {
-						CryptGenRandom(rCryptHandle, 1, (BYTE*) &cS);
-						aBuffer[j] = cS;
-					}
+	*pCount = (unsigned int) iCount;
 
-					fwrite(aBuffer, 1, cBUFFER, pFile);
-				}
+	return 0;
+}
 
-				if (iTailSize > 0) {
 
-					for (unsigned int j = 0; j < iNumBytes; j++) {
-						CryptGenRandom(rCryptHandle, 1, (BYTE*) &cS);
-						aBuffer[j] = cS;
-					}
+/**
+	* Wall-clock time for throughput reports (clock() sums CPU time over all threads).
+	*
+	* @param   void
+	* @return  double, seconds
+*/
 
-					fwrite(aBuffer, 1, iTailSize, pFile);
-				}
-			}
-			else { /* write to stdout */
+double getTime(void) {
 
-				for (unsigned int i = 0; i < iNumPages; i++) {
+	#ifdef __linux
+		struct timespec tNow;
+		clock_gettime(CLOCK_MONOTONIC, &tNow);
+		return (double) tNow.tv_sec + (double) tNow.tv_nsec * 1e-9;
+	#elif _WIN64
+		LARGE_INTEGER iCount, iFreq;
+		QueryPerformanceCounter(&iCount);
+		QueryPerformanceFrequency(&iFreq);
+		return (double) iCount.QuadPart / (double) iFreq.QuadPart;
+	#endif
+}
 
-					for (unsigned int j = 0; j < iNumBytes; j++) {
-						CryptGenRandom(rCryptHandle, 1, (BYTE*) &cS);
-						aBuffer[j] = cS;
-					}
 
-					fwrite(aBuffer, 1, cBUFFER, stdout);
-				}
+#ifdef _WIN64
 
-				if (iTailSize > 0) {
 
-					for (unsigned int j = 0; j < iNumBytes; j++) {
-						CryptGenRandom(rCryptHandle, 1, (BYTE*) &cS);
-						aBuffer[j] = cS;
-					}
+/**
+	* Open an existing output file for one thread, positioned at the start of its section.
+	*
+	* @param   char const* sFile, output file
+	* @param   uint64_t iOffset, section start
+	* @return  FILE*, NULL on error
+*/
 
-					fwrite(aBuffer, 1, iTailSize, stdout);
-				}
-			}
+FILE* openSection(char const* sFile, uint64_t iOffset) {
 
-			if (CryptReleaseContext(rCryptHandle, 0)) {
-				rCryptHandle = 0;
-			}
+	FILE* pSection = fopen(sFile, "r+b");
+	int iSeek = -1;
+
+	if (pSection == NULL) {
+		return NULL;
+	}
+
+	iSeek = _fseeki64(pSection, (long long) iOffset, SEEK_SET);
+
+	if (iSeek != 0) {
+		fclose(pSection);
+		return NULL;
+	}
+
+	return pSection;
+}
 
+
+/**
+	* Thread function: generate a section of the stream with the librnd64 generator and write it out.
+	*
+	* @param   void pointer st, params struct
+	* @return  DWORD
+*/
+
+DWORD WINAPI generateStream(LPVOID st) {
+
+	Params_t* params = (Params_t*) st;
+	uint64_t iThreadBytes = params->bytes;
+
+	unsigned int iBuffer = params->iBuffer;
+	uint64_t iNumPages = iThreadBytes / iBuffer;
+	unsigned int iTailSize = iThreadBytes % iBuffer;
+	uint8_t* pBuffer = (uint8_t*) arenaAcquire(params->pArena); /* one per thread: never NULL */
+
+	for (uint64_t i = 0; i < iNumPages; i++) {
+
+		if (rnd64_fill(params->pCtx, pBuffer, iBuffer) != 0) {
+			fprintf(stderr, "\n%s: insufficient crypto random bytes available.\n\n", pFilename);
+			goto exit;
 		}
 
-		return 0;
+		fwrite(pBuffer, 1, iBuffer, params->pOut);
 	}
 
+	if (iTailSize > 0) {
+
+		if (rnd64_fill(params->pCtx, pBuffer, iTailSize) != 0) {
+			fprintf(stderr, "\n%s: insufficient crypto random bytes available.\n\n", pFilename);
+			goto exit;
+		}
+
+		fwrite(pBuffer, 1, iTailSize, params->pOut);
+	}
+
+	exit:
+
+	arenaRelease(params->pArena, pBuffer);
+
+	return 0;
+}
+
+
 #endif
 
 
@@ -675,10 +977,50 @@ void menu(char* const pFName) {
 	printf("\n\nUsage:\n");
 	printf("\t\t%s [option] <size> [file]", pFName);
 	printf("\n\t\t%s [option] <size> | <prog>", pFName);
+	printf("\n\t\t%s [option] --count <n> --size <size> --pattern <name_%%04d>", pFName);
+	printf("\n\t\t%s [option] --count <n> --size-dist <min:max> --tree <dir>", pFName);
+	printf("\n\t\t%s [option] --count <n> --size-dist <min:max> --tar [file]", pFName);
+	printf("\n\t\t%s [option] --tune", pFName);
+	printf("\n\t\t%s --analyze [file]", pFName);
+	printf("\n\t\t%s [-a|-r|-c] --selftest [size]", pFName);
+	printf("\n\t\t%s [option] --sink=none <size> | --duration <time> [--memstress <size>]", pFName);
+	printf("\n\t\t%s [-a|-c] --overwrite <file|device> [--passes random,zero,verify] [--discard]", pFName);
+	printf("\n\t\t%s [option] <size> <file> --order random [--block <size>] [--qd <n>]", pFName);
+	printf("\n\t\t%s [option] --mutate <pct> [--block <size>] [--ops block,range,insert,delete] <file>", pFName);
 	printf("\n\nOptions:");
 	printf("\n\t\t-a\t chars 0-255    (all)");
 	printf("\n\t\t-f\t single char    (fastest)");
 	printf("\n\t\t-r\t chars 33-126   (restrict)");
 	printf("\n\t\t-c\t crypto bytes");
+	printf("\n\n\t\t-t <n>\t threads        (default: CPUs, up to 1024)");
+	printf("\n\t\t-s <n>\t seed           (reproducible -a / -r output)");
+	printf("\n\n\t\t--count <n>\t  number of files");
+	printf("\n\t\t--pattern <p>\t  file names, e.g. data_%%04d.bin");
+	printf("\n\t\t--open <n>\t  files open concurrently (default: threads, up to 1024)");
+	printf("\n\n\t\t--tree <dir>\t  small-file tree of --count files");
+	printf("\n\t\t--fanout <n>\t  subdirectories per directory (default: 16, up to 65536)");
+	printf("\n\t\t--depth <n>\t  directory levels (default: 2, 0 to 16; up to 16M leaf directories)");
+	printf("\n\t\t--size-dist <min:max>  log-uniform file sizes, e.g. 4k:1m");
+	printf("\n\t\t--tar\t\t  the tree as a ustar archive to [file] or stdout, no files on disk");
+	printf("\n\n\t\t--tcp <host:port>  send to a TCP listener");
+	printf("\n\t\t--udp <host:port>  send UDP datagrams");
+	printf("\n\t\t-P <n>\t\t  parallel connections (default: 1, up to 1024)");
+	printf("\n\t\t--zerocopy\t  MSG_ZEROCOPY TCP sends");
+	printf("\n\n\t\t--isa <name>\t  fill kernels: auto, scalar, sse2, avx2, avx512 (default: auto, %s)", rnd64_isa());
+	printf("\n\t\t--tune\t\t  calibrate buffer, threads and pipe size; saved per host");
+	printf("\n\t\t--analyze\t  nulls, entropy, chi-square, serial correlation of [file] or stdin");
+	printf("\n\t\t--selftest\t  statistical tests of each engine (default: 1G per engine)");
+	printf("\n\n\t\t--sink=none\t  generate without output: pure generation MB/s, per thread every 10 s");
+	printf("\n\t\t--duration <time>  run time instead of <size>, e.g. 90s, 30m, 12h");
+	printf("\n\t\t--memstress <size>  cycle buffers through a checksummed working set, e.g. 8g");
+	printf("\n\n\t\t--overwrite <path>  rewrite an existing file or block device in place");
+	printf("\n\t\t--passes <list>\t  random, zero, one, 0xNN, verify (default: random)");
+	printf("\n\t\t--discard\t  discard (TRIM) the target first");
+	printf("\n\t\t--qd <n>\t  concurrent writes (default: 32, up to 1024)");
+	printf("\n\n\t\t--order random\t  write [file] in a seeded shuffled block order; IOPS and latency");
+	printf("\n\t\t--block <size>\t  write block (default: 4k, up to 1m)");
+	printf("\n\t\t--mutate <pct>\t  change a seeded random percentage of <file>'s blocks in place, e.g. 2%%");
+	printf("\n\t\t--ops <list>\t  mutations: block, range, insert, delete (default: block)");
+	printf("\n\t\t--manifest <file>  changed extents (default: <file>.manifest)");
 	printf("\n\n\t\tsize\t 1K, 100M, 8G\n\n");
 }
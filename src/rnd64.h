@@ -20,17 +20,17 @@
 #include <time.h>
 #include <ctype.h>
 #include <inttypes.h>
+#include <getopt.h>
 
 #ifdef __linux
 	#include <pthread.h>
-	#include <sys/sysinfo.h>
 	#include <unistd.h>
-	#define RANDOM_PATH "/dev/urandom"
 #elif _WIN64
 	#include <windows.h>
-	#include <wincrypt.h> /* CryptAcquireContext, CryptGenRandom */
 #endif
 
+#include "librnd64.h"
+
 
 /* defines */
 #define RND64_VERSION "0.42 mt"
@@ -39,42 +39,136 @@
 
 
 /* constants */
-float const cMBRECIP = 0.000976562;
-unsigned int const cBUFFER = 64 * KB; /* optimum 64kB cache size (~L1) on CPUs tested */
-unsigned int const cNB = 0;
+static float const cMBRECIP = 0.000976562;
+static unsigned int const cBUFFER = 64 * KB; /* optimum 64kB cache size (~L1) on CPUs tested; --tune finds the host's */
+static unsigned int const cBUFFER_MAX = 1024 * KB; /* largest tuned stream buffer */
+static unsigned int const cTHREADS_MAX = 1024; /* -t limit */
+static unsigned int const cOPEN_MAX = 1024; /* --open limit */
+static unsigned int const cQUEUE_MAX = 1024; /* --qd limit */
+static unsigned int const cSTREAMS_MAX = 1024; /* -P limit */
+static unsigned int const cBLOCK_MAX = 1024 * KB; /* --block limit: one block per writer is allocated up front */
+static unsigned int const cFANOUT_MAX = 65536; /* --fanout limit */
+static unsigned int const cDEPTH_MAX = 16; /* --depth limit */
+static uint64_t const cLEAVES_MAX = 16 * 1048576; /* --fanout ^ --depth limit: every leaf directory is created */
 
 
 /* structs */
+typedef struct Arena Arena_t;  /* rnd64_arena.c */
+typedef struct Output Output_t; /* rnd64_output.c */
+
 typedef struct {
-	char* filename;
-	uint64_t bytes;
-} Params_t;
+	rnd64_mode_t iMode;
+	rnd64_engine_t iEngine;
+	uint64_t iSeed;            /* -s, 0 = automatic */
+	unsigned int iThreads;     /* -t, default: logical CPUs */
+	uint64_t iBytes;           /* <size> / --size */
+	char* sOutput;             /* [file] */
+	uint64_t iCount;           /* --count: files to fan out to */
+	char* sPattern;            /* --pattern: printf-style integer pattern, e.g. data_%04d.bin */
+	unsigned int iOpen;        /* --open: files open concurrently, default: threads */
+	char* sTree;               /* --tree: small-file tree root directory */
+	unsigned int iFanout;      /* --fanout: subdirectories per directory */
+	unsigned int iDepth;       /* --depth: directory levels below the root */
+	uint64_t iSizeMin;         /* --size-dist MIN:MAX, log-uniform file sizes */
+	uint64_t iSizeMax;
+	char* sTcp;                /* --tcp host:port */
+	char* sUdp;                /* --udp host:port */
+	unsigned int iStreams;     /* -P: parallel connections */
+	int iZeroCopy;             /* --zerocopy: MSG_ZEROCOPY TCP sends */
+	int iTune;                 /* --tune: calibrate and save the host profile */
+	unsigned int iBuffer;      /* stream buffer bytes: cBUFFER or the host profile's */
+	unsigned int iPipeSize;    /* stdout pipe capacity from the host profile, 0 = unchanged */
+	int iAnalyze;              /* --analyze: statistics of [file] or stdin */
+	char* sInput;              /* --analyze [file] */
+	int iSelfTest;             /* --selftest: 1 = every engine, 2 = the -a / -r / -c given */
+	int iSinkNone;             /* --sink=none: generate without output */
+	uint64_t iDuration;        /* --duration: seconds, instead of <size> */
+	uint64_t iMemStress;       /* --memstress: working set bytes, implies --sink=none */
+	char* sOverwrite;          /* --overwrite: existing file or block device */
+	char* sPasses;             /* --passes: e.g. random,zero,verify */
+	int iDiscard;              /* --discard: BLKDISCARD / hole punch before the passes */
+	unsigned int iQueueDepth;  /* --qd: concurrent I/Os, 0 = the mode's default */
+	int iRandomOrder;          /* --order random: shuffled block writes to [file] */
+	uint64_t iBlock;           /* --block: write block bytes */
+	double fMutate;            /* --mutate: percentage of [file]'s blocks to change */
+	char* sOps;                /* --ops: mutations, e.g. block,range,insert,delete */
+	char* sManifest;           /* --manifest: changed extents, default [file].manifest */
+	int iTar;                  /* --tar: ustar archive of the --count file tree to [file] or stdout */
+} Options_t;
 
 typedef struct {
-	uint64_t state;
-	uint64_t inc;
-} pcg32_random_t;
+	uint64_t iCount;           /* elements */
+	unsigned int iHalfBits;    /* Feistel half width: 2^(2 * iHalfBits) >= iCount */
+	uint64_t iMask;
+	uint64_t aKeys[4];
+} Permutation_t;
+
+typedef struct {
+	uint64_t iBytes;
+	uint64_t iWrites;          /* writev() calls */
+	double fBlocked;           /* seconds in writev(): waiting on the consumer */
+	double fPaused;            /* seconds producers waited for a queue slot, summed over threads */
+} OutputStats_t;
+
+typedef struct {
+	FILE* pOut;
+	rnd64_ctx_t* pCtx;
+	uint64_t bytes;
+	unsigned int iBuffer;
+	Arena_t* pArena;
+} Params_t;
 
 
 /* functions */
-void seed_pcg_random(void);
-inline uint32_t pcg32_random_r(pcg32_random_t* rng);
 void menu(char* const pFName);
-
-#ifdef __linux
-	void* generateAll(void* st);
-	void* generateRestricted(void* st);
-	void* generateSingleChar(void* st);
-	void* generateCrypto(void* st);
-#elif _WIN64
-	DWORD WINAPI generateAll(LPVOID st);
-	DWORD WINAPI generateRestricted(LPVOID st);
-	DWORD WINAPI generateSingleChar(LPVOID st);
-	DWORD WINAPI generateCrypto(LPVOID st);
+int parseOptions(int iArgCount, char* aArgV[], Options_t* pOptions);
+int parseSize(char const* sSize, uint64_t* pBytes);
+int parseDuration(char const* sDuration, uint64_t* pSeconds);
+int parseCount(char const* sCount, char const* sOption, unsigned int iMax, unsigned int* pCount);
+double getTime(void);
+
+int fanOut(Options_t const* pOptions);
+int createTree(Options_t const* pOptions);
+void treePath(char* sPath, uint64_t iDir, unsigned int iLevel, unsigned int iFanout);
+uint64_t treeFileSize(Options_t const* pOptions, uint64_t iSeed, uint64_t iFile);
+int tarStream(Options_t const* pOptions);
+int netSend(Options_t const* pOptions);
+
+int tune(Options_t const* pOptions);
+int analyze(Options_t const* pOptions);
+int selfTest(Options_t const* pOptions);
+int stress(Options_t const* pOptions);
+int overwrite(Options_t const* pOptions);
+int randomWrite(Options_t const* pOptions);
+int mutate(Options_t const* pOptions);
+void loadProfile(Options_t* pOptions);
+unsigned int setPipeSize(int iFd, unsigned int iSize);
+unsigned int pipeMaxSize(void);
+
+Arena_t* arenaCreate(size_t iSize, unsigned int iCount);
+void* arenaAcquire(Arena_t* pArena);
+void arenaRelease(Arena_t* pArena, void* pBuffer);
+char const* arenaPages(Arena_t const* pArena);
+void arenaDestroy(Arena_t* pArena);
+
+Output_t* outputCreate(int iFd, size_t iChunk, unsigned int iSlots);
+uint8_t* outputAcquire(Output_t* pOutput, uint64_t iSeq);
+void outputCommit(Output_t* pOutput, uint64_t iSeq, size_t iLen);
+void outputAbort(Output_t* pOutput);
+int outputFinish(Output_t* pOutput, uint64_t iCount, OutputStats_t* pStats);
+int streamRun(Options_t const* pOptions, int iFd, OutputStats_t* pStats, double* pTime);
+int streamOut(Options_t const* pOptions);
+
+uint64_t mix64(uint64_t iX);
+void permutationInit(Permutation_t* pPerm, uint64_t iCount, uint64_t iKey);
+uint64_t permute(Permutation_t const* pPerm, uint64_t iIndex);
+
+/* Windows: one FILE handle per thread section; Linux streams through the ordered output stage */
+#ifdef _WIN64
+	FILE* openSection(char const* sFile, uint64_t iOffset);
+	DWORD WINAPI generateStream(LPVOID st);
 #endif
 
 
 /* global variables */
-extern FILE* pFile;
 extern char* pFilename;
-extern pcg32_random_t pcg32_random;
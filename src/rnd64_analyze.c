@@ -0,0 +1,497 @@
+/**
+	* RND64
+	* rnd64_analyze.c
+	*
+	* Stream analyzer: --analyze reads a file or stdin and reports null count, Shannon entropy, chi-square,
+	* mean and serial correlation, for validating generator output inline in a pipeline.
+	*
+	* @author        Martin Latter
+	* @copyright     Martin Latter, April 2014
+	* @version       0.42 mt
+	* @license       GNU GPL version 3.0 (GPL v3); https://www.gnu.org/licenses/gpl-3.0.html
+	* @link          https://github.com/Tinram/RND64.git
+	*
+	* Regular files are mapped and 1 MB blocks are claimed by the worker threads directly.
+	* Pipes are enlarged to /proc/sys/fs/pipe-max-size and read() in 1 MB blocks into arena buffers,
+	* queued to the workers. Each worker keeps its own statistics; they are merged at the end.
+	* Serial correlation follows 'ent': neighbouring bytes, including the last byte with the first.
+*/
+
+
+#include "rnd64.h"
+#include <math.h>
+
+#ifdef __linux
+	#include <fcntl.h>
+	#include <errno.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+#endif
+
+
+#ifdef __linux
+
+
+/* constants */
+static size_t const cBLOCK = 1024 * KB;    /* work unit */
+static size_t const cPAIR_SPAN = 32 * KB;  /* neighbour products per 32-bit sum: 255 * 255 * 32 k < 2^32 */
+
+
+/* structs */
+typedef struct {
+	uint64_t aHist[256];
+	uint64_t iPairs;           /* sum of x[i] * x[i + 1] within blocks */
+} AnalyzeStats_t;
+
+typedef struct {
+	uint8_t const* pMap;       /* mapped file, NULL when reading a pipe */
+	uint64_t iSize;
+	uint64_t iNextBlock;       /* next block to claim from the map */
+	pthread_mutex_t rLock;     /* pipe queue */
+	pthread_cond_t rQueued;    /* a block is queued, or the input ended */
+	pthread_cond_t rFreed;     /* a buffer was returned to the arena */
+	Arena_t* pArena;
+	uint8_t** aQueue;
+	size_t* aLens;
+	unsigned int iDepth;
+	unsigned int iHead;
+	unsigned int iQueued;
+	int iEnd;
+} Analyze_t;
+
+typedef struct {
+	Analyze_t* pShared;
+	AnalyzeStats_t stats;
+} AnalyzeWorker_t;
+
+
+/**
+	* Accumulate a block: byte histogram and neighbour products.
+	* Four interleaved count tables break the store-to-load dependency on repeated bytes; the product loop
+	* vectorises, and is cloned for AVX2 / AVX-512 with the best chosen at load (ifunc).
+	*
+	* @param   AnalyzeStats_t* pStats
+	* @param   uint8_t* pData
+	* @param   size_t iLen, up to cBLOCK
+	* @return  void
+*/
+
+#if defined(__x86_64__) && defined(__GNUC__)
+	__attribute__((target_clones("arch=x86-64-v4", "avx2", "default")))
+#endif
+static void analyzeBlock(AnalyzeStats_t* pStats, uint8_t const* pData, size_t iLen) {
+
+	uint32_t aCount[4][256];
+	size_t i = 0;
+
+	memset(aCount, 0, sizeof(aCount));
+
+	for (; i + 8 <= iLen; i += 8) {
+
+		uint64_t iWord;
+		memcpy(&iWord, pData + i, 8);
+
+		aCount[0][iWord & 0xFF]++;
+		aCount[1][(iWord >> 8) & 0xFF]++;
+		aCount[2][(iWord >> 16) & 0xFF]++;
+		aCount[3][(iWord >> 24) & 0xFF]++;
+		aCount[0][(iWord >> 32) & 0xFF]++;
+		aCount[1][(iWord >> 40) & 0xFF]++;
+		aCount[2][(iWord >> 48) & 0xFF]++;
+		aCount[3][iWord >> 56]++;
+	}
+
+	for (; i < iLen; i++) {
+		aCount[0][pData[i]]++;
+	}
+
+	for (unsigned int c = 0; c < 256; c++) {
+		pStats->aHist[c] += (uint64_t) aCount[0][c] + aCount[1][c] + aCount[2][c] + aCount[3][c];
+	}
+
+	for (size_t iSpan = 0; iSpan + 1 < iLen; iSpan += cPAIR_SPAN) {
+
+		size_t iSpanEnd = (iSpan + cPAIR_SPAN < iLen - 1) ? iSpan + cPAIR_SPAN : iLen - 1;
+		uint32_t iSum = 0;
+
+		for (size_t j = iSpan; j < iSpanEnd; j++) {
+			iSum += (uint32_t) pData[j] * pData[j + 1];
+		}
+
+		pStats->iPairs += iSum;
+	}
+}
+
+
+/**
+	* Thread function: analyze mapped blocks, or queued pipe blocks, until the input is exhausted.
+	*
+	* @param   void pointer st, AnalyzeWorker_t struct
+	* @return  void* / null
+*/
+
+static void* analyzeWorker(void* st) {
+
+	AnalyzeWorker_t* pWorker = (AnalyzeWorker_t*) st;
+	Analyze_t* pShared = pWorker->pShared;
+
+	if (pShared->pMap != NULL) {
+
+		for (;;) {
+
+			uint64_t iOffset = __atomic_fetch_add(&pShared->iNextBlock, 1, __ATOMIC_RELAXED) * cBLOCK;
+
+			if (iOffset >= pShared->iSize) {
+				break;
+			}
+
+			analyzeBlock(&pWorker->stats, pShared->pMap + iOffset, (pShared->iSize - iOffset < cBLOCK) ? (size_t) (pShared->iSize - iOffset) : cBLOCK);
+		}
+
+		return NULL;
+	}
+
+	for (;;) {
+
+		pthread_mutex_lock(&pShared->rLock);
+
+		while (pShared->iQueued == 0 && ! pShared->iEnd) {
+			pthread_cond_wait(&pShared->rQueued, &pShared->rLock);
+		}
+
+		if (pShared->iQueued == 0) {
+			pthread_mutex_unlock(&pShared->rLock);
+			break;
+		}
+
+		uint8_t* pBlock = pShared->aQueue[pShared->iHead];
+		size_t iLen = pShared->aLens[pShared->iHead];
+
+		pShared->iHead = (pShared->iHead + 1) % pShared->iDepth;
+		pShared->iQueued--;
+		pthread_mutex_unlock(&pShared->rLock);
+
+		analyzeBlock(&pWorker->stats, pBlock, iLen);
+
+		arenaRelease(pShared->pArena, pBlock);
+
+		pthread_mutex_lock(&pShared->rLock);
+		pthread_cond_signal(&pShared->rFreed);
+		pthread_mutex_unlock(&pShared->rLock);
+	}
+
+	return NULL;
+}
+
+
+/**
+	* Read a pipe (or other stream) into arena blocks and queue them to the workers.
+	*
+	* @param   Analyze_t* pShared
+	* @param   int iFd
+	* @param   uint64_t* pTotal, bytes read
+	* @param   uint64_t* pCross, neighbour products across block boundaries, including last x first
+	* @return  int, 0 on success, -1 on read error (message printed)
+*/
+
+static int analyzeRead(Analyze_t* pShared, int iFd, uint64_t* pTotal, uint64_t* pCross) {
+
+	uint8_t iFirst = 0;
+	uint8_t iLast = 0;
+	int iResult = 0;
+
+	for (;;) {
+
+		uint8_t* pBlock = NULL;
+		size_t iLen = 0;
+
+		pthread_mutex_lock(&pShared->rLock);
+
+		while ((pBlock = (uint8_t*) arenaAcquire(pShared->pArena)) == NULL) {
+			pthread_cond_wait(&pShared->rFreed, &pShared->rLock);
+		}
+
+		pthread_mutex_unlock(&pShared->rLock);
+
+		while (iLen < cBLOCK) {
+
+			ssize_t iRead = read(iFd, pBlock + iLen, cBLOCK - iLen);
+
+			if (iRead < 0 && errno == EINTR) {
+				continue;
+			}
+
+			if (iRead < 0) {
+				fprintf(stderr, "\n%s: read failure (%s).\n\n", pFilename, strerror(errno));
+				iResult = -1;
+				break;
+			}
+
+			if (iRead == 0) {
+				break;
+			}
+
+			iLen += (size_t) iRead;
+		}
+
+		if (iLen == 0) {
+			arenaRelease(pShared->pArena, pBlock);
+			break;
+		}
+
+		if (*pTotal == 0) {
+			iFirst = pBlock[0];
+		}
+		else {
+			*pCross += (uint64_t) iLast * pBlock[0];
+		}
+
+		iLast = pBlock[iLen - 1];
+		*pTotal += iLen;
+
+		pthread_mutex_lock(&pShared->rLock);
+		pShared->aQueue[(pShared->iHead + pShared->iQueued) % pShared->iDepth] = pBlock;
+		pShared->aLens[(pShared->iHead + pShared->iQueued) % pShared->iDepth] = iLen;
+		pShared->iQueued++;
+		pthread_cond_signal(&pShared->rQueued);
+		pthread_mutex_unlock(&pShared->rLock);
+
+		if (iLen < cBLOCK) { /* end of input, or error */
+			break;
+		}
+	}
+
+	if (*pTotal > 0) {
+		*pCross += (uint64_t) iLast * iFirst;
+	}
+
+	pthread_mutex_lock(&pShared->rLock);
+	pShared->iEnd = 1;
+	pthread_cond_broadcast(&pShared->rQueued);
+	pthread_mutex_unlock(&pShared->rLock);
+
+	return iResult;
+}
+
+
+/**
+	* Analyze a file, or stdin, and print its statistics.
+	*
+	* @param   Options_t* pOptions
+	* @return  int, EXIT_SUCCESS / EXIT_FAILURE
+*/
+
+int analyze(Options_t const* pOptions) {
+
+	unsigned int iNumThreads = pOptions->iThreads;
+	unsigned int iStarted = 0;
+	char const* sName = (pOptions->sInput != NULL) ? pOptions->sInput : "stdin";
+	int iFd = STDIN_FILENO;
+	int iError = 0;
+	uint64_t iTotal = 0;
+	uint64_t iCross = 0;
+	double fStart = 0;
+	double fTime = 0;
+	struct stat rStat;
+	Analyze_t shared;
+	AnalyzeStats_t stats;
+
+	pthread_t rThreadID[iNumThreads];
+	AnalyzeWorker_t aWorkers[iNumThreads];
+	uint8_t* aQueue[2 * iNumThreads + 2];
+	size_t aLens[2 * iNumThreads + 2];
+
+	memset(&shared, 0, sizeof(shared));
+	memset(&stats, 0, sizeof(stats));
+
+	if (pOptions->sInput != NULL) {
+
+		iFd = open(pOptions->sInput, O_RDONLY);
+
+		if (iFd < 0) {
+			fprintf(stderr, "\n%s: '%s' cannot be opened (%s).\n\n", pFilename, pOptions->sInput, strerror(errno));
+			return EXIT_FAILURE;
+		}
+	}
+
+	fStart = getTime();
+
+	if (fstat(iFd, &rStat) == 0 && S_ISREG(rStat.st_mode) && rStat.st_size > 0) {
+
+		void* pMap = mmap(NULL, (size_t) rStat.st_size, PROT_READ, MAP_PRIVATE, iFd, 0);
+
+		if (pMap != MAP_FAILED) {
+			shared.pMap = (uint8_t const*) pMap;
+			shared.iSize = (uint64_t) rStat.st_size;
+		}
+	}
+
+	if (shared.pMap == NULL) {
+
+		/* fewer, larger reads */
+		setPipeSize(iFd, pipeMaxSize());
+
+		shared.iDepth = 2 * iNumThreads + 2;
+		shared.aQueue = aQueue;
+		shared.aLens = aLens;
+		shared.pArena = arenaCreate(cBLOCK, shared.iDepth);
+
+		if (shared.pArena == NULL) {
+			fprintf(stderr, "\n%s: insufficient memory for %u buffers of %zu bytes.\n\n", pFilename, shared.iDepth, cBLOCK);
+
+			if (pOptions->sInput != NULL) {
+				close(iFd);
+			}
+
+			return EXIT_FAILURE;
+		}
+
+		pthread_mutex_init(&shared.rLock, NULL);
+		pthread_cond_init(&shared.rQueued, NULL);
+		pthread_cond_init(&shared.rFreed, NULL);
+	}
+
+	for (unsigned int i = 0; i < iNumThreads; i++) {
+
+		memset(&aWorkers[i], 0, sizeof(AnalyzeWorker_t));
+		aWorkers[i].pShared = &shared;
+
+		if (pthread_create(&rThreadID[i], NULL, analyzeWorker, &aWorkers[i]) != 0) {
+			fprintf(stderr, "\n%s: analysis thread cannot be started.\n\n", pFilename);
+			iError = -1;
+			break;
+		}
+
+		iStarted++;
+	}
+
+	if (iError != 0) {
+
+		/* release the started workers: no input is queued */
+		if (shared.pMap == NULL) {
+			pthread_mutex_lock(&shared.rLock);
+			shared.iEnd = 1;
+			pthread_cond_broadcast(&shared.rQueued);
+			pthread_mutex_unlock(&shared.rLock);
+		}
+	}
+	else if (shared.pMap != NULL) {
+
+		iTotal = shared.iSize;
+
+		for (uint64_t iOffset = cBLOCK; iOffset < iTotal; iOffset += cBLOCK) {
+			iCross += (uint64_t) shared.pMap[iOffset - 1] * shared.pMap[iOffset];
+		}
+
+		iCross += (uint64_t) shared.pMap[iTotal - 1] * shared.pMap[0];
+	}
+	else {
+		iError = analyzeRead(&shared, iFd, &iTotal, &iCross);
+	}
+
+	for (unsigned int i = 0; i < iStarted; i++) {
+
+		pthread_join(rThreadID[i], NULL);
+
+		for (unsigned int c = 0; c < 256; c++) {
+			stats.aHist[c] += aWorkers[i].stats.aHist[c];
+		}
+
+		stats.iPairs += aWorkers[i].stats.iPairs;
+	}
+
+	fTime = getTime() - fStart;
+
+	if (shared.pMap != NULL) {
+		munmap((void*) shared.pMap, shared.iSize);
+	}
+	else {
+		pthread_cond_destroy(&shared.rFreed);
+		pthread_cond_destroy(&shared.rQueued);
+		pthread_mutex_destroy(&shared.rLock);
+		arenaDestroy(shared.pArena);
+	}
+
+	if (pOptions->sInput != NULL) {
+		close(iFd);
+	}
+
+	if (iStarted < iNumThreads) {
+		return EXIT_FAILURE;
+	}
+
+	if (iTotal == 0) {
+		fprintf(stderr, "\n%s: %s: no data to analyze.\n\n", pFilename, sName);
+		return EXIT_FAILURE;
+	}
+
+	/* statistics from the histogram */
+	double fN = (double) iTotal;
+	double fExpected = fN / 256;
+	double fEntropy = 0;
+	double fChi = 0;
+	long double fSum = 0;
+	long double fSumSq = 0;
+
+	for (unsigned int c = 0; c < 256; c++) {
+
+		double fCount = (double) stats.aHist[c];
+		double fDiff = fCount - fExpected;
+
+		if (stats.aHist[c] > 0) {
+			fEntropy -= (fCount / fN) * log2(fCount / fN);
+		}
+
+		fChi += fDiff * fDiff / fExpected;
+		fSum += (long double) c * stats.aHist[c];
+		fSumSq += (long double) c * c * stats.aHist[c];
+	}
+
+	long double fPairs = (long double) stats.iPairs + iCross;
+	long double fDenom = fN * fSumSq - fSum * fSum;
+
+	printf("\n%s: %"PRIu64" bytes analyzed\n\n", sName, iTotal);
+	printf("nulls: %"PRIu64"\n", stats.aHist[0]);
+	printf("entropy: %0.6f bits per byte\n", fEntropy);
+	printf("chi-square: %0.2f (255 degrees of freedom)\n", fChi);
+	printf("mean: %0.4f (random: 127.5)\n", (double) (fSum / fN));
+
+	if (fDenom != 0) {
+		printf("serial correlation: %0.6f (uncorrelated: 0.0)\n", (double) ((fN * fPairs - fSum * fSum) / fDenom));
+	}
+	else {
+		printf("serial correlation: undefined (constant input)\n");
+	}
+
+	printf("time: %d s %d ms\n", (int) fTime, (int) (fTime * 1000) % 1000);
+
+	if (fTime > 0) {
+		printf("MB/s: %0.2f\n", (iTotal * cMBRECIP * cMBRECIP) / fTime);
+	}
+
+	printf("\n");
+
+	return iError ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+
+#elif _WIN64
+
+
+/**
+	* Analyze a file, or stdin (Linux only: mmap(), pipe sizing).
+	*
+	* @param   Options_t* pOptions
+	* @return  int, EXIT_FAILURE
+*/
+
+int analyze(Options_t const* pOptions) {
+
+	(void) pOptions;
+	fprintf(stderr, "\n%s: --analyze is not available on this platform.\n\n", pFilename);
+
+	return EXIT_FAILURE;
+}
+
+
+#endif
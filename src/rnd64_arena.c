@@ -0,0 +1,230 @@
+/**
+	* RND64
+	* rnd64_arena.c
+	*
+	* Buffer arena: every generation and I/O buffer of a run allocated once, up front, in one huge-page-backed
+	* mapping, and handed out to threads from a lock-free free list.
+	*
+	* @author        Martin Latter
+	* @copyright     Martin Latter, April 2014
+	* @version       0.42 mt
+	* @license       GNU GPL version 3.0 (GPL v3); https://www.gnu.org/licenses/gpl-3.0.html
+	* @link          https://github.com/Tinram/RND64.git
+	*
+	* Linux tries 2 MB MAP_HUGETLB pages (reserved in /proc/sys/vm/nr_hugepages), then a 2 MB-aligned mapping
+	* with madvise(MADV_HUGEPAGE) for transparent huge pages, then normal pages. Windows uses VirtualAlloc().
+	* Buffers are page-aligned (so cache-line-aligned) and the mapping is pre-faulted at creation, so threads
+	* start on resident memory and total buffer memory is fixed by the arena size.
+*/
+
+
+#include "rnd64.h"
+
+#ifdef __linux
+	#include <sys/mman.h>
+#endif
+
+
+/* constants */
+static size_t const cPAGE = 4 * KB;
+static size_t const cHUGE_PAGE = 2048 * KB;
+
+
+/* structs */
+struct Arena {
+	uint8_t* pBase;            /* first buffer */
+	void* pMap;                /* mapping, for release */
+	size_t iMapLen;
+	size_t iStride;            /* buffer size rounded up to whole pages */
+	unsigned int iCount;
+	char const* sPages;        /* "hugetlb", "thp", or "4k" */
+	uint64_t iHead;            /* free list: ABA tag << 32 | (buffer index + 1), 0 = empty */
+	uint32_t aNext[];          /* free list links, buffer index + 1 */
+};
+
+
+/**
+	* Map iLen bytes: huge pages where available, pre-faulted.
+	*
+	* @param   Arena_t* pArena, pMap / iMapLen / pBase / sPages populated
+	* @param   size_t iLen
+	* @return  int, 0 on success, -1 on failure
+*/
+
+static int arenaMap(Arena_t* pArena, size_t iLen) {
+
+	#ifdef __linux
+
+		size_t iHugeLen = (iLen + cHUGE_PAGE - 1) & ~(cHUGE_PAGE - 1);
+
+		pArena->pMap = mmap(NULL, iHugeLen, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_POPULATE, -1, 0);
+
+		if (pArena->pMap != MAP_FAILED) {
+			pArena->iMapLen = iHugeLen;
+			pArena->pBase = (uint8_t*) pArena->pMap;
+			pArena->sPages = "hugetlb";
+			return 0;
+		}
+
+		/* over-map by one huge page to place the buffers on a 2 MB boundary for THP */
+		pArena->iMapLen = iHugeLen + cHUGE_PAGE;
+		pArena->pMap = mmap(NULL, pArena->iMapLen, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+		if (pArena->pMap == MAP_FAILED) {
+			pArena->pMap = NULL;
+			return -1;
+		}
+
+		pArena->pBase = (uint8_t*) (((uintptr_t) pArena->pMap + cHUGE_PAGE - 1) & ~(uintptr_t) (cHUGE_PAGE - 1));
+		pArena->sPages = (madvise(pArena->pBase, iHugeLen, MADV_HUGEPAGE) == 0) ? "thp" : "4k";
+
+	#elif _WIN64
+
+		pArena->iMapLen = iLen;
+		pArena->pMap = VirtualAlloc(NULL, iLen, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+
+		if (pArena->pMap == NULL) {
+			return -1;
+		}
+
+		pArena->pBase = (uint8_t*) pArena->pMap;
+		pArena->sPages = "4k";
+
+	#endif
+
+	/* pre-fault once here rather than in every thread */
+	for (size_t i = 0; i < iLen; i += cPAGE) {
+		pArena->pBase[i] = 0;
+	}
+
+	return 0;
+}
+
+
+/**
+	* Create an arena of iCount buffers of iSize bytes.
+	*
+	* @param   size_t iSize, bytes per buffer
+	* @param   unsigned int iCount, buffers
+	* @return  Arena_t*, NULL on failure
+*/
+
+Arena_t* arenaCreate(size_t iSize, unsigned int iCount) {
+
+	Arena_t* pArena = NULL;
+
+	if (iSize == 0 || iCount == 0) {
+		return NULL;
+	}
+
+	pArena = (Arena_t*) calloc(1, sizeof(Arena_t) + iCount * sizeof(uint32_t));
+
+	if (pArena == NULL) {
+		return NULL;
+	}
+
+	pArena->iStride = (iSize + cPAGE - 1) & ~(cPAGE - 1);
+	pArena->iCount = iCount;
+
+	if (arenaMap(pArena, pArena->iStride * iCount) != 0) {
+		free(pArena);
+		return NULL;
+	}
+
+	/* free list in buffer order: 1 -> 2 -> ... -> iCount */
+	for (unsigned int i = 0; i < iCount; i++) {
+		pArena->aNext[i] = (i + 1 < iCount) ? i + 2 : 0;
+	}
+
+	pArena->iHead = 1;
+
+	return pArena;
+}
+
+
+/**
+	* Take a buffer from the free list.
+	*
+	* @param   Arena_t* pArena
+	* @return  void*, NULL if every buffer is in use
+*/
+
+void* arenaAcquire(Arena_t* pArena) {
+
+	uint64_t iHead = __atomic_load_n(&pArena->iHead, __ATOMIC_ACQUIRE);
+
+	for (;;) {
+
+		uint32_t iTop = (uint32_t) iHead;
+
+		if (iTop == 0) {
+			return NULL;
+		}
+
+		uint64_t iNew = (((iHead >> 32) + 1) << 32) | __atomic_load_n(&pArena->aNext[iTop - 1], __ATOMIC_RELAXED);
+
+		if (__atomic_compare_exchange_n(&pArena->iHead, &iHead, iNew, 1, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+			return pArena->pBase + (size_t) (iTop - 1) * pArena->iStride;
+		}
+	}
+}
+
+
+/**
+	* Return a buffer to the free list.
+	*
+	* @param   Arena_t* pArena
+	* @param   void* pBuffer, from arenaAcquire(); NULL is ignored
+	* @return  void
+*/
+
+void arenaRelease(Arena_t* pArena, void* pBuffer) {
+
+	if (pBuffer == NULL) {
+		return;
+	}
+
+	uint32_t iIndex = (uint32_t) (((uint8_t*) pBuffer - pArena->pBase) / pArena->iStride);
+	uint64_t iHead = __atomic_load_n(&pArena->iHead, __ATOMIC_RELAXED);
+
+	do {
+		__atomic_store_n(&pArena->aNext[iIndex], (uint32_t) iHead, __ATOMIC_RELAXED);
+	}
+	while ( ! __atomic_compare_exchange_n(&pArena->iHead, &iHead, (((iHead >> 32) + 1) << 32) | (iIndex + 1), 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+
+/**
+	* Page type backing the arena, for reports.
+	*
+	* @param   Arena_t* pArena
+	* @return  char*, "hugetlb", "thp", or "4k"
+*/
+
+char const* arenaPages(Arena_t const* pArena) {
+
+	return pArena->sPages;
+}
+
+
+/**
+	* Release an arena and its mapping; its buffers must no longer be in use.
+	*
+	* @param   Arena_t* pArena
+	* @return  void
+*/
+
+void arenaDestroy(Arena_t* pArena) {
+
+	if (pArena == NULL) {
+		return;
+	}
+
+	#ifdef __linux
+		munmap(pArena->pMap, pArena->iMapLen);
+	#elif _WIN64
+		VirtualFree(pArena->pMap, 0, MEM_RELEASE);
+	#endif
+
+	free(pArena);
+}
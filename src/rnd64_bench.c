@@ -0,0 +1,736 @@
+/**
+	* RND64
+	* rnd64_bench.c
+	*
+	* Benchmark sweep for 'make bench': generator modes x thread counts x buffer sizes x sinks,
+	* reporting GB/s, cycles/byte and scaling efficiency, as JSON compared against a stored baseline.
+	*
+	* @author        Martin Latter
+	* @copyright     Martin Latter, April 2014
+	* @version       0.42 mt
+	* @license       GNU GPL version 3.0 (GPL v3); https://www.gnu.org/licenses/gpl-3.0.html
+	* @link          https://github.com/Tinram/RND64.git
+	*
+	* Usage:         rnd64_bench [-s size] [-n repeats] [-i isa] [-x rnd64 binary] [-o results.json] [-b baseline.json] [-T tolerance %]
+	*
+	*                Each combination is run -n times (default 3) and the fastest run kept, to damp noise.
+	*                -i selects the fill kernels (default: auto), to compare ISA levels on one host.
+	*
+	* Sinks:         memory   generation only
+	*                null     write() to /dev/null
+	*                pipe     write() to a pipe drained by a reader thread
+	*                tmpfs    pwrite() to a file in /dev/shm
+	*
+	*                The -x sinks time the rnd64 binary itself, so its output code is covered too:
+	*                out-null  stdout to /dev/null
+	*                out-pipe  stdout to a pipe drained by a reader thread
+	*                out-file  [file] in /dev/shm
+	*                The binary runs with its default buffer (no host profile) and the -t of the row.
+	*
+	* Linux only.
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <ctype.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+	#include <x86intrin.h>
+	#define HAVE_TSC 1
+#else
+	#define HAVE_TSC 0
+#endif
+
+#include "librnd64.h"
+
+
+/* defines */
+#define NUM_MODES 4
+#define NUM_SINKS 7
+#define FIRST_BINARY_SINK 4
+#define NUM_BUFFERS 4
+#define MAX_RESULTS 4096
+
+
+/* constants */
+static char const* const aModeNames[NUM_MODES] = {"a", "f", "r", "c"};
+static char const* const aSinkNames[NUM_SINKS] = {"memory", "null", "pipe", "tmpfs", "out-null", "out-pipe", "out-file"};
+static size_t const aBufferSizes[NUM_BUFFERS] = {16 * 1024, 64 * 1024, 256 * 1024, 1024 * 1024};
+static size_t const cBINARY_BUFFER = 64 * 1024; /* rnd64 stream buffer without a host profile */
+static char const* const cTMPFS_PATH = "/dev/shm/rnd64_bench.tmp";
+
+
+/* structs */
+typedef struct {
+	unsigned int iMode;
+	unsigned int iSink;
+	size_t iBuffer;
+	unsigned int iThreads;
+	double fGBps;
+	double fCpb;               /* cycles/byte, < 0 when unavailable */
+	double fEfficiency;
+} Result_t;
+
+typedef struct {
+	rnd64_ctx_t* pCtx;
+	int iFd;                   /* -1 for the memory sink */
+	int iPositional;           /* pwrite() at iOffset */
+	uint64_t iOffset;
+	uint64_t iBytes;
+	size_t iBuffer;
+	int iError;
+} BenchWorker_t;
+
+
+/* global variables */
+char* pFilename = NULL;
+
+
+/**
+	* Wall-clock or process CPU time.
+	*
+	* @param   clockid_t iClock
+	* @return  double, seconds
+*/
+
+static double getClock(clockid_t iClock) {
+
+	struct timespec tNow;
+	clock_gettime(iClock, &tNow);
+
+	return (double) tNow.tv_sec + (double) tNow.tv_nsec * 1e-9;
+}
+
+
+/**
+	* Estimate the TSC rate, to convert CPU time to cycles.
+	*
+	* @param   void
+	* @return  double, Hz, 0 when unavailable
+*/
+
+static double tscHz(void) {
+
+	#if HAVE_TSC
+
+		struct timespec tSleep = {0, 100000000};
+		double fStart = getClock(CLOCK_MONOTONIC);
+		uint64_t iStart = __rdtsc();
+
+		nanosleep(&tSleep, NULL);
+
+		return (double) (__rdtsc() - iStart) / (getClock(CLOCK_MONOTONIC) - fStart);
+
+	#else
+
+		return 0;
+
+	#endif
+}
+
+
+/**
+	* Convert a size with a k, m, or g suffix to bytes.
+	*
+	* @param   char* sSize
+	* @return  uint64_t, 0 on error
+*/
+
+static uint64_t benchSize(char const* sSize) {
+
+	char* pEnd = NULL;
+	uint64_t iBytes = strtoull(sSize, &pEnd, 10);
+
+	switch (tolower(*pEnd)) {
+		case 'k': return iBytes << 10;
+		case 'm': return iBytes << 20;
+		case 'g': return iBytes << 30;
+		default: return 0;
+	}
+}
+
+
+/**
+	* Thread function: generate and write one share of a run.
+	*
+	* @param   void pointer st, BenchWorker_t struct
+	* @return  void* / null
+*/
+
+static void* benchWorker(void* st) {
+
+	BenchWorker_t* pWorker = (BenchWorker_t*) st;
+	uint8_t* pBuffer = (uint8_t*) malloc(pWorker->iBuffer);
+	uint64_t iDone = 0;
+
+	if (pBuffer == NULL) {
+		pWorker->iError = 1;
+		return NULL;
+	}
+
+	while (iDone < pWorker->iBytes) {
+
+		size_t iLen = (pWorker->iBytes - iDone < pWorker->iBuffer) ? (size_t) (pWorker->iBytes - iDone) : pWorker->iBuffer;
+
+		if (rnd64_fill(pWorker->pCtx, pBuffer, iLen) != 0) {
+			pWorker->iError = 1;
+			break;
+		}
+
+		if (pWorker->iFd >= 0) {
+
+			ssize_t iWritten = pWorker->iPositional
+				? pwrite(pWorker->iFd, pBuffer, iLen, (off_t) (pWorker->iOffset + iDone))
+				: write(pWorker->iFd, pBuffer, iLen);
+
+			if (iWritten <= 0) {
+				pWorker->iError = 1;
+				break;
+			}
+
+			iLen = (size_t) iWritten;
+		}
+		else {
+			/* keep the generated buffer observable */
+			__asm__ __volatile__("" : : "r" (pBuffer) : "memory");
+		}
+
+		iDone += iLen;
+	}
+
+	free(pBuffer);
+
+	return NULL;
+}
+
+
+/**
+	* Thread function: drain the pipe sink.
+	*
+	* @param   void pointer st, read end descriptor
+	* @return  void* / null
+*/
+
+static void* pipeReader(void* st) {
+
+	int iFd = *(int*) st;
+	size_t const iSize = 1024 * 1024;
+	uint8_t* pBuffer = (uint8_t*) malloc(iSize);
+
+	while (pBuffer != NULL && read(iFd, pBuffer, iSize) > 0) {
+	}
+
+	free(pBuffer);
+
+	return NULL;
+}
+
+
+/**
+	* Time one combination.
+	*
+	* @param   Result_t* pResult, mode / sink / buffer / threads set; GB/s and cycles/byte filled in
+	* @param   uint64_t iBytes, total output
+	* @param   double fHz, TSC rate
+	* @return  int, 0 on success, -1 when the sink or generator is unavailable
+*/
+
+static int benchRun(Result_t* pResult, uint64_t iBytes, double fHz) {
+
+	unsigned int iThreads = pResult->iThreads;
+	rnd64_mode_t iMode = (pResult->iMode == 1) ? RND64_MODE_SINGLE : (pResult->iMode == 2) ? RND64_MODE_RESTRICTED : RND64_MODE_ALL;
+	rnd64_engine_t iEngine = (pResult->iMode == 3) ? RND64_ENGINE_CRYPTO : RND64_ENGINE_PCG32;
+	rnd64_ctx_t* pCtx = rnd64_create(iMode, iEngine, 1);
+	pthread_t rThreadID[iThreads];
+	pthread_t rReader;
+	BenchWorker_t aWorkers[iThreads];
+	int aPipe[2] = {-1, -1};
+	int iFd = -1;
+	uint64_t iShare = iBytes / iThreads;
+
+	if (pCtx == NULL) {
+		return -1;
+	}
+
+	if (pResult->iSink == 1) {
+		iFd = open("/dev/null", O_WRONLY);
+	}
+	else if (pResult->iSink == 2) {
+
+		if (pipe(aPipe) == 0) {
+
+			if (pthread_create(&rReader, NULL, pipeReader, &aPipe[0]) == 0) {
+				iFd = aPipe[1];
+			}
+			else {
+				close(aPipe[0]);
+				close(aPipe[1]);
+			}
+		}
+	}
+	else if (pResult->iSink == 3) {
+		iFd = open(cTMPFS_PATH, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+	}
+
+	if (pResult->iSink != 0 && iFd < 0) {
+		rnd64_destroy(pCtx);
+		return -1;
+	}
+
+	int iError = 0;
+
+	for (unsigned int i = 0; i < iThreads; i++) {
+		aWorkers[i].pCtx = rnd64_clone(pCtx);
+		aWorkers[i].iError = 0;
+		aWorkers[i].iFd = iFd;
+		aWorkers[i].iPositional = (pResult->iSink == 3);
+		aWorkers[i].iOffset = i * iShare;
+		aWorkers[i].iBytes = (i == iThreads - 1) ? iBytes - i * iShare : iShare;
+		aWorkers[i].iBuffer = pResult->iBuffer;
+
+		if (aWorkers[i].pCtx != NULL) {
+			rnd64_stream(aWorkers[i].pCtx, i);
+		}
+	}
+
+	double fCpuStart = getClock(CLOCK_PROCESS_CPUTIME_ID);
+	double fStart = getClock(CLOCK_MONOTONIC);
+
+	unsigned int iStarted = 0;
+
+	for (unsigned int i = 0; i < iThreads; i++) {
+
+		if (aWorkers[i].pCtx == NULL || pthread_create(&rThreadID[i], NULL, benchWorker, &aWorkers[i]) != 0) {
+			iError = 1;
+			break;
+		}
+
+		iStarted++;
+	}
+
+	for (unsigned int i = 0; i < iStarted; i++) {
+		pthread_join(rThreadID[i], NULL);
+		iError |= aWorkers[i].iError;
+	}
+
+	double fTime = getClock(CLOCK_MONOTONIC) - fStart;
+	double fCpu = getClock(CLOCK_PROCESS_CPUTIME_ID) - fCpuStart;
+
+	if (pResult->iSink == 2) {
+		close(aPipe[1]);
+		pthread_join(rReader, NULL);
+		close(aPipe[0]);
+	}
+	else if (iFd >= 0) {
+		close(iFd);
+	}
+
+	if (pResult->iSink == 3) {
+		unlink(cTMPFS_PATH);
+	}
+
+	for (unsigned int i = 0; i < iThreads; i++) {
+		rnd64_destroy(aWorkers[i].pCtx);
+	}
+
+	rnd64_destroy(pCtx);
+
+	/* a failed fill or write would time a short run */
+	if (iError) {
+		return -1;
+	}
+
+	pResult->fGBps = (fTime > 0) ? iBytes / fTime / 1e9 : 0;
+	pResult->fCpb = (fHz > 0) ? fCpu * fHz / iBytes : -1;
+
+	return 0;
+}
+
+
+/**
+	* Time one combination through the rnd64 binary: the same output code as a user's run.
+	*
+	* @param   Result_t* pResult, mode / sink / threads set; GB/s and cycles/byte filled in
+	* @param   uint64_t iBytes, total output
+	* @param   double fHz, TSC rate
+	* @param   char* sBinary, rnd64 path
+	* @param   char* sIsa, --isa for the binary, NULL for its default
+	* @return  int, 0 on success, -1 when the binary or sink is unavailable, or the run fails
+*/
+
+static int benchBinary(Result_t* pResult, uint64_t iBytes, double fHz, char const* sBinary, char const* sIsa) {
+
+	char sMode[4];
+	char sThreads[16];
+	char sSize[32];
+	char const* aArgs[12];
+	unsigned int iArg = 0;
+	int aPipe[2] = {-1, -1};
+	int iNull = open("/dev/null", O_WRONLY);
+	int iOut = iNull;
+	int iStatus = 0;
+	int iReader = 0;
+	pthread_t rReader;
+	struct rusage rStart;
+	struct rusage rEnd;
+	pid_t iPid;
+
+	if (iNull < 0) {
+		return -1;
+	}
+
+	if (pResult->iSink == FIRST_BINARY_SINK + 1) {
+
+		if (pipe(aPipe) != 0) {
+			close(iNull);
+			return -1;
+		}
+
+		iOut = aPipe[1];
+	}
+
+	snprintf(sMode, sizeof(sMode), "-%s", aModeNames[pResult->iMode]);
+	snprintf(sThreads, sizeof(sThreads), "%u", pResult->iThreads);
+	snprintf(sSize, sizeof(sSize), "%"PRIu64"k", iBytes >> 10);
+
+	aArgs[iArg++] = sBinary;
+	aArgs[iArg++] = sMode;
+	aArgs[iArg++] = "-s";
+	aArgs[iArg++] = "1";
+	aArgs[iArg++] = "-t";
+	aArgs[iArg++] = sThreads;
+
+	if (sIsa != NULL) {
+		aArgs[iArg++] = "--isa";
+		aArgs[iArg++] = sIsa;
+	}
+
+	aArgs[iArg++] = sSize;
+
+	if (pResult->iSink == FIRST_BINARY_SINK + 2) {
+		aArgs[iArg++] = cTMPFS_PATH;
+	}
+
+	aArgs[iArg] = NULL;
+
+	getrusage(RUSAGE_CHILDREN, &rStart);
+	double fStart = getClock(CLOCK_MONOTONIC);
+
+	iPid = fork();
+
+	if (iPid == 0) {
+
+		/* no host profile: every host and run measures the same configuration */
+		setenv("XDG_CACHE_HOME", "/nonexistent", 1);
+		dup2(iOut, STDOUT_FILENO);
+		dup2(iNull, STDERR_FILENO);
+		execv(sBinary, (char* const*) aArgs);
+		_exit(127);
+	}
+
+	if (aPipe[0] >= 0) {
+
+		close(aPipe[1]);
+
+		/* no reader: closing the read end fails the child's writes, and the run */
+		if (iPid > 0 && pthread_create(&rReader, NULL, pipeReader, &aPipe[0]) == 0) {
+			iReader = 1;
+		}
+		else {
+			close(aPipe[0]);
+			aPipe[0] = -1;
+		}
+	}
+
+	if (iPid > 0) {
+		waitpid(iPid, &iStatus, 0);
+	}
+
+	double fTime = getClock(CLOCK_MONOTONIC) - fStart;
+	getrusage(RUSAGE_CHILDREN, &rEnd);
+
+	if (iReader) {
+		pthread_join(rReader, NULL);
+		close(aPipe[0]);
+	}
+
+	close(iNull);
+
+	if (pResult->iSink == FIRST_BINARY_SINK + 2) {
+		unlink(cTMPFS_PATH);
+	}
+
+	if (iPid < 0 || (pResult->iSink == FIRST_BINARY_SINK + 1 && ! iReader) || ! WIFEXITED(iStatus) || WEXITSTATUS(iStatus) != 0) {
+		return -1;
+	}
+
+	double fCpu = (double) (rEnd.ru_utime.tv_sec - rStart.ru_utime.tv_sec + rEnd.ru_stime.tv_sec - rStart.ru_stime.tv_sec)
+		+ (double) (rEnd.ru_utime.tv_usec - rStart.ru_utime.tv_usec + rEnd.ru_stime.tv_usec - rStart.ru_stime.tv_usec) * 1e-6;
+
+	pResult->fGBps = (fTime > 0) ? iBytes / fTime / 1e9 : 0;
+	pResult->fCpb = (fHz > 0) ? fCpu * fHz / iBytes : -1;
+
+	return 0;
+}
+
+
+/**
+	* Compare results with a baseline file written by a previous run.
+	*
+	* @param   char* sBaseline
+	* @param   Result_t* aResults
+	* @param   unsigned int iResults
+	* @param   double fTolerance, allowed GB/s drop, percent
+	* @return  int, number of regressions, -1 when no baseline
+*/
+
+static int compareBaseline(char const* sBaseline, Result_t const* aResults, unsigned int iResults, double fTolerance) {
+
+	FILE* pBase = fopen(sBaseline, "r");
+	char sLine[512];
+	int iRegressions = 0;
+	unsigned int iCompared = 0;
+
+	if (pBase == NULL) {
+		return -1;
+	}
+
+	printf("\nbaseline %s (tolerance %0.1f%%):\n\n", sBaseline, fTolerance);
+
+	while (fgets(sLine, sizeof(sLine), pBase) != NULL) {
+
+		char sMode[4];
+		char sSink[16];
+		unsigned int iBuffer = 0;
+		unsigned int iThreads = 0;
+		double fGBps = 0;
+
+		if (sscanf(sLine, " {\"mode\": \"%3[^\"]\", \"sink\": \"%15[^\"]\", \"buffer\": %u, \"threads\": %u, \"gbps\": %lf",
+			sMode, sSink, &iBuffer, &iThreads, &fGBps) != 5) {
+			continue;
+		}
+
+		for (unsigned int i = 0; i < iResults; i++) {
+
+			Result_t const* pResult = &aResults[i];
+
+			if (strcmp(sMode, aModeNames[pResult->iMode]) != 0 || strcmp(sSink, aSinkNames[pResult->iSink]) != 0
+				|| iBuffer != pResult->iBuffer || iThreads != pResult->iThreads) {
+				continue;
+			}
+
+			double fChange = (fGBps > 0) ? (pResult->fGBps / fGBps - 1) * 100 : 0;
+
+			iCompared++;
+
+			if (fChange < -fTolerance) {
+				printf("  REGRESSION  -%s %-8s %7u B  %3u threads  %7.3f -> %7.3f GB/s  (%+0.1f%%)\n",
+					sMode, sSink, iBuffer, iThreads, fGBps, pResult->fGBps, fChange);
+				iRegressions++;
+			}
+		}
+	}
+
+	fclose(pBase);
+
+	printf("\n  %u combinations compared, %d regression(s)\n\n", iCompared, iRegressions);
+
+	return iRegressions;
+}
+
+
+int main(int iArgCount, char* aArgV[]) {
+
+	uint64_t iBytes = 256ULL << 20;
+	char const* sOutput = "bench.json";
+	char const* sBaseline = NULL;
+	char const* sBinary = NULL;
+	char const* sIsa = NULL;
+	double fTolerance = 10;
+	unsigned int iRepeats = 3;
+	int iOpt = 0;
+
+	static Result_t aResults[MAX_RESULTS];
+	unsigned int iResults = 0;
+	unsigned int aThreads[32];
+	unsigned int iThreadSteps = 0;
+	unsigned int iCpus = rnd64_cpu_count();
+
+	pFilename = aArgV[0];
+
+	while ((iOpt = getopt(iArgCount, aArgV, "s:n:i:x:o:b:T:")) != -1) {
+
+		switch (iOpt) {
+
+			case 's':
+				iBytes = benchSize(optarg);
+				break;
+
+			case 'n':
+				iRepeats = (unsigned int) strtoul(optarg, NULL, 10);
+				break;
+
+			case 'i':
+				if (rnd64_set_isa(optarg) != 0) {
+					fprintf(stderr, "\n%s: ISA '%s' is unknown or not supported by this CPU.\n\n", pFilename, optarg);
+					return EXIT_FAILURE;
+				}
+				sIsa = optarg;
+				break;
+
+			case 'x':
+				sBinary = optarg;
+				break;
+
+			case 'o':
+				sOutput = optarg;
+				break;
+
+			case 'b':
+				sBaseline = optarg;
+				break;
+
+			case 'T':
+				fTolerance = strtod(optarg, NULL);
+				break;
+
+			default:
+				fprintf(stderr, "\nUsage: %s [-s size] [-n repeats] [-i isa] [-x rnd64 binary] [-o results.json] [-b baseline.json] [-T tolerance %%]\n\n", pFilename);
+				return EXIT_FAILURE;
+		}
+	}
+
+	if (iRepeats == 0) {
+		iRepeats = 1;
+	}
+
+	if (iBytes == 0) {
+		fprintf(stderr, "\n%s: please specify the run size with a suffix of k, m, or g\n\n", pFilename);
+		return EXIT_FAILURE;
+	}
+
+	/* thread counts: powers of 2 up to the CPU count, and the CPU count */
+	for (unsigned int t = 1; t < iCpus && iThreadSteps < 31; t *= 2) {
+		aThreads[iThreadSteps++] = t;
+	}
+
+	aThreads[iThreadSteps++] = iCpus;
+
+	double fHz = tscHz();
+
+	printf("\nRND64 benchmark: %u CPUs, %s kernels, %"PRIu64" bytes per run\n\n", iCpus, rnd64_isa(), iBytes);
+	printf("  mode  sink        buffer  threads     GB/s   cyc/B   scaling\n");
+
+	for (unsigned int m = 0; m < NUM_MODES; m++) {
+		for (unsigned int s = 0; s < NUM_SINKS; s++) {
+			for (unsigned int b = 0; b < NUM_BUFFERS; b++) {
+
+				double fSingle = 0;
+
+				/* the binary picks its own buffer */
+				if (s >= FIRST_BINARY_SINK && (sBinary == NULL || aBufferSizes[b] != cBINARY_BUFFER)) {
+					continue;
+				}
+
+				for (unsigned int t = 0; t < iThreadSteps && iResults < MAX_RESULTS; t++) {
+
+					Result_t* pResult = &aResults[iResults];
+
+					pResult->iMode = m;
+					pResult->iSink = s;
+					pResult->iBuffer = aBufferSizes[b];
+					pResult->iThreads = aThreads[t];
+
+					Result_t best;
+
+					best.fGBps = -1;
+
+					for (unsigned int r = 0; r < iRepeats; r++) {
+
+						int iRun = (s >= FIRST_BINARY_SINK) ? benchBinary(pResult, iBytes, fHz, sBinary, sIsa) : benchRun(pResult, iBytes, fHz);
+
+						if (iRun != 0) {
+							break;
+						}
+
+						if (pResult->fGBps > best.fGBps) {
+							best = *pResult;
+						}
+					}
+
+					if (best.fGBps < 0) {
+						continue;
+					}
+
+					*pResult = best;
+
+					if (t == 0) {
+						fSingle = pResult->fGBps;
+					}
+
+					pResult->fEfficiency = (fSingle > 0) ? pResult->fGBps / (fSingle * pResult->iThreads) : 0;
+
+					printf("  -%s    %-8s  %7zu  %7u  %7.3f  %6.2f   %6.1f%%\n", aModeNames[m], aSinkNames[s], pResult->iBuffer,
+						pResult->iThreads, pResult->fGBps, pResult->fCpb, pResult->fEfficiency * 100);
+					fflush(stdout);
+
+					iResults++;
+				}
+			}
+		}
+	}
+
+	FILE* pOut = fopen(sOutput, "w");
+
+	if (pOut == NULL) {
+		fprintf(stderr, "\n%s: %s cannot be written.\n\n", pFilename, sOutput);
+		return EXIT_FAILURE;
+	}
+
+	fprintf(pOut, "{\n  \"version\": \"%s\",\n  \"cpus\": %u,\n  \"isa\": \"%s\",\n  \"bytes\": %"PRIu64",\n  \"results\": [\n", LIBRND64_VERSION, iCpus, rnd64_isa(), iBytes);
+
+	for (unsigned int i = 0; i < iResults; i++) {
+
+		Result_t const* pResult = &aResults[i];
+		char sCpb[32];
+
+		if (pResult->fCpb < 0) {
+			strcpy(sCpb, "null");
+		}
+		else {
+			snprintf(sCpb, sizeof(sCpb), "%0.3f", pResult->fCpb);
+		}
+
+		fprintf(pOut, "    {\"mode\": \"%s\", \"sink\": \"%s\", \"buffer\": %zu, \"threads\": %u, \"gbps\": %0.4f, \"cpb\": %s, \"efficiency\": %0.3f}%s\n",
+			aModeNames[pResult->iMode], aSinkNames[pResult->iSink], pResult->iBuffer, pResult->iThreads,
+			pResult->fGBps, sCpb, pResult->fEfficiency, (i < iResults - 1) ? "," : "");
+	}
+
+	fprintf(pOut, "  ]\n}\n");
+	fclose(pOut);
+
+	printf("\nresults: %s\n", sOutput);
+
+	if (sBaseline != NULL) {
+
+		int iRegressions = compareBaseline(sBaseline, aResults, iResults, fTolerance);
+
+		if (iRegressions < 0) {
+			printf("\nno baseline %s: 'make bench-baseline' to store one\n\n", sBaseline);
+		}
+		else if (iRegressions > 0) {
+			return EXIT_FAILURE;
+		}
+	}
+
+	return EXIT_SUCCESS;
+}
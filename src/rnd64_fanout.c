@@ -0,0 +1,465 @@
+/**
+	* RND64
+	* rnd64_fanout.c
+	*
+	* Multi-file fan-out: one run writes --count files named from --pattern, scheduling chunks of
+	* --open concurrently-open files across the thread pool.
+	*
+	* @author        Martin Latter
+	* @copyright     Martin Latter, April 2014
+	* @version       0.42 mt
+	* @license       GNU GPL version 3.0 (GPL v3); https://www.gnu.org/licenses/gpl-3.0.html
+	* @link          https://github.com/Tinram/RND64.git
+	*
+	* Each file is PCG32 stream <file index> of the seed, so a file's content is independent of scheduling.
+*/
+
+
+#include "rnd64.h"
+
+#ifdef __linux
+	#include <fcntl.h>
+	#include <errno.h>
+#endif
+
+
+#ifdef __linux
+
+
+/* constants */
+static unsigned int const cCHUNK = 1024 * KB; /* scheduling unit: large enough to amortise the scheduler lock */
+
+
+/* structs */
+typedef struct {
+	int iFd;                   /* -1 when free */
+	uint64_t iFile;            /* file index */
+	uint64_t iNext;            /* next offset to hand out */
+	uint64_t iDone;            /* bytes written */
+} FanSlot_t;
+
+typedef struct {
+	Options_t const* pOptions;
+	pthread_mutex_t rLock;
+	pthread_cond_t rSlotFree;  /* signalled when a file completes or on error */
+	FanSlot_t* aSlots;
+	Arena_t* pArena;           /* one chunk buffer per thread */
+	unsigned int iTurn;        /* round-robin slot cursor */
+	uint64_t iNextFile;
+	uint64_t iFilesDone;
+	int iError;
+} FanOut_t;
+
+typedef struct {
+	FanOut_t* pFan;
+	rnd64_ctx_t* pCtx;
+} FanWorker_t;
+
+
+/**
+	* Expand the first %d / %0Nd directive of a filename pattern with a file index; %% is a literal %.
+	* (Parsed here rather than passed to snprintf(): the pattern is user input.)
+	*
+	* @param   char* sOut, destination
+	* @param   size_t iOutSize
+	* @param   char* sPattern
+	* @param   uint64_t iIndex
+	* @return  int, 1 if a directive was expanded, 0 if none, -1 on overflow
+*/
+
+static int expandPattern(char* sOut, size_t iOutSize, char const* sPattern, uint64_t iIndex) {
+
+	size_t iLen = 0;
+	int iExpanded = 0;
+
+	for (char const* p = sPattern; *p != '\0'; p++) {
+
+		char sNum[32];
+		char const* pNum = NULL;
+
+		if (*p == '%' && p[1] == '%') {
+			pNum = "%";
+			p++;
+		}
+		else if (*p == '%' && ! iExpanded) {
+
+			char const* q = p + 1;
+			int iZero = (*q == '0');
+			int iWidth = (int) strtol(q, (char**) &q, 10);
+
+			if (*q != 'd' && *q != 'u' && *q != 'i') {
+				return -1;
+			}
+
+			if (iZero) {
+				snprintf(sNum, sizeof(sNum), "%0*"PRIu64, iWidth, iIndex);
+			}
+			else {
+				snprintf(sNum, sizeof(sNum), "%*"PRIu64, iWidth, iIndex);
+			}
+
+			pNum = sNum;
+			iExpanded = 1;
+			p = q;
+		}
+
+		if (pNum != NULL) {
+
+			size_t iNumLen = strlen(pNum);
+
+			if (iLen + iNumLen >= iOutSize) {
+				return -1;
+			}
+
+			memcpy(sOut + iLen, pNum, iNumLen);
+			iLen += iNumLen;
+		}
+		else {
+
+			if (iLen + 1 >= iOutSize) {
+				return -1;
+			}
+
+			sOut[iLen++] = *p;
+		}
+	}
+
+	sOut[iLen] = '\0';
+
+	return iExpanded;
+}
+
+
+/**
+	* Claim the next chunk: round-robin over open files, opening the next file into a free slot.
+	* Called with the scheduler lock held.
+	*
+	* @param   FanOut_t* pFan
+	* @param   unsigned int* pSlot, claimed slot
+	* @param   uint64_t* pOffset, chunk offset
+	* @param   uint64_t* pLen, chunk length
+	* @return  int, 1 if a chunk was claimed, 0 when no work remains
+*/
+
+static int claimChunk(FanOut_t* pFan, unsigned int* pSlot, uint64_t* pOffset, uint64_t* pLen) {
+
+	Options_t const* pOptions = pFan->pOptions;
+	unsigned int iSlots = pOptions->iOpen;
+
+	if (pFan->iError) {
+		return 0;
+	}
+
+	for (unsigned int k = 0; k < iSlots; k++) {
+
+		unsigned int s = (pFan->iTurn + k) % iSlots;
+		FanSlot_t* pEntry = &pFan->aSlots[s];
+
+		if (pEntry->iFd < 0 && pFan->iNextFile < pOptions->iCount) {
+
+			char sName[4096];
+
+			expandPattern(sName, sizeof(sName), pOptions->sPattern, pFan->iNextFile);
+
+			pEntry->iFd = open(sName, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+			if (pEntry->iFd < 0) {
+				fprintf(stderr, "\n%s: output file '%s' cannot be written (%s).\n\n", pFilename, sName, strerror(errno));
+				pFan->iError = 1;
+				return 0;
+			}
+
+			pEntry->iFile = pFan->iNextFile++;
+			pEntry->iNext = 0;
+			pEntry->iDone = 0;
+		}
+
+		if (pEntry->iFd >= 0 && pEntry->iNext < pOptions->iBytes) {
+
+			*pSlot = s;
+			*pOffset = pEntry->iNext;
+			*pLen = pOptions->iBytes - pEntry->iNext;
+
+			if (*pLen > cCHUNK) {
+				*pLen = cCHUNK;
+			}
+
+			pEntry->iNext += *pLen;
+			pFan->iTurn = s + 1;
+
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+
+/**
+	* Thread function: generate and write chunks until all files are complete.
+	*
+	* @param   void pointer st, FanWorker_t struct
+	* @return  void* / null
+*/
+
+static void* fanWorker(void* st) {
+
+	FanWorker_t* pWorker = (FanWorker_t*) st;
+	FanOut_t* pFan = pWorker->pFan;
+	uint8_t* pBuffer = (uint8_t*) arenaAcquire(pFan->pArena);
+
+	unsigned int iSlot = 0;
+	uint64_t iOffset = 0;
+	uint64_t iLen = 0;
+
+	if (pBuffer == NULL) {
+		pthread_mutex_lock(&pFan->rLock);
+		pFan->iError = 1;
+		pthread_cond_broadcast(&pFan->rSlotFree);
+		pthread_mutex_unlock(&pFan->rLock);
+		return NULL;
+	}
+
+	for (;;) {
+
+		pthread_mutex_lock(&pFan->rLock);
+
+		int iClaimed = 0;
+
+		/* every open file handed out: wait for one to complete and free its slot */
+		while ( ! (iClaimed = claimChunk(pFan, &iSlot, &iOffset, &iLen)) && ! pFan->iError && pFan->iNextFile < pFan->pOptions->iCount) {
+			pthread_cond_wait(&pFan->rSlotFree, &pFan->rLock);
+		}
+
+		int iFd = pFan->aSlots[iSlot].iFd;
+		uint64_t iFile = pFan->aSlots[iSlot].iFile;
+		pthread_mutex_unlock(&pFan->rLock);
+
+		if ( ! iClaimed) {
+			break;
+		}
+
+		rnd64_stream(pWorker->pCtx, iFile);
+		rnd64_seek(pWorker->pCtx, iOffset);
+
+		/* fill in cache-sized pieces, write as one chunk */
+		for (uint64_t i = 0; i < iLen; i += cBUFFER) {
+
+			size_t iPiece = (iLen - i < cBUFFER) ? (size_t) (iLen - i) : cBUFFER;
+
+			if (rnd64_fill(pWorker->pCtx, pBuffer + i, iPiece) != 0) {
+				fprintf(stderr, "\n%s: insufficient crypto random bytes available.\n\n", pFilename);
+				iLen = 0;
+				break;
+			}
+		}
+
+		for (uint64_t i = 0; i < iLen; ) {
+
+			ssize_t iWritten = pwrite(iFd, pBuffer + i, iLen - i, (off_t) (iOffset + i));
+
+			if (iWritten <= 0) {
+				fprintf(stderr, "\n%s: write failure (%s).\n\n", pFilename, strerror(errno));
+				iLen = 0;
+				break;
+			}
+
+			i += (uint64_t) iWritten;
+		}
+
+		pthread_mutex_lock(&pFan->rLock);
+
+		if (iLen == 0) {
+			pFan->iError = 1;
+			pthread_cond_broadcast(&pFan->rSlotFree);
+		}
+		else {
+
+			FanSlot_t* pSlot = &pFan->aSlots[iSlot];
+
+			pSlot->iDone += iLen;
+
+			if (pSlot->iDone == pFan->pOptions->iBytes) {
+				close(pSlot->iFd);
+				pSlot->iFd = -1;
+				pFan->iFilesDone++;
+				pthread_cond_broadcast(&pFan->rSlotFree);
+			}
+		}
+
+		pthread_mutex_unlock(&pFan->rLock);
+	}
+
+	arenaRelease(pFan->pArena, pBuffer);
+
+	return NULL;
+}
+
+
+/**
+	* Write --count files of <size> bytes each.
+	*
+	* @param   Options_t* pOptions
+	* @return  int, EXIT_SUCCESS / EXIT_FAILURE
+*/
+
+int fanOut(Options_t const* pOptions) {
+
+	unsigned int iNumThreads = pOptions->iThreads;
+	unsigned int iStarted = 0;
+	pthread_t* aThreadID = NULL;
+	FanWorker_t* aWorkers = NULL;
+	FanSlot_t* aSlots = NULL;
+	FanOut_t fan;
+
+	char sFirst[4096];
+	char sSecond[4096];
+	rnd64_ctx_t* pCtx = NULL;
+	double fStart = 0;
+	double fTime = 0;
+
+	/* check the pattern names distinct files */
+	int iExpand = expandPattern(sFirst, sizeof(sFirst), pOptions->sPattern, 0);
+	expandPattern(sSecond, sizeof(sSecond), pOptions->sPattern, pOptions->iCount - 1);
+
+	if (iExpand < 0 || (iExpand == 0 && pOptions->iCount > 1)) {
+		fprintf(stderr, "\n%s: --pattern needs one integer directive for the file number  e.g. data_%%04d.bin\n\n", pFilename);
+		return EXIT_FAILURE;
+	}
+
+	pCtx = rnd64_create(pOptions->iMode, pOptions->iEngine, pOptions->iSeed);
+
+	if (pCtx == NULL) {
+		fprintf(stderr, "\n%s: secure data generation unavailable.\n\n", pFilename);
+		return EXIT_FAILURE;
+	}
+
+	/* per-thread and per-open-file state sized by -t and --open: heap, not stack */
+	aThreadID = (pthread_t*) calloc(iNumThreads, sizeof(pthread_t));
+	aWorkers = (FanWorker_t*) calloc(iNumThreads, sizeof(FanWorker_t));
+	aSlots = (FanSlot_t*) calloc(pOptions->iOpen, sizeof(FanSlot_t));
+
+	memset(&fan, 0, sizeof(fan));
+	fan.pOptions = pOptions;
+	fan.aSlots = aSlots;
+	fan.pArena = arenaCreate(cCHUNK, iNumThreads);
+
+	if (aThreadID == NULL || aWorkers == NULL || aSlots == NULL || fan.pArena == NULL) {
+		fprintf(stderr, "\n%s: insufficient memory for %u buffers of %u bytes.\n\n", pFilename, iNumThreads, cCHUNK);
+		arenaDestroy(fan.pArena);
+		free(aSlots);
+		free(aWorkers);
+		free(aThreadID);
+		rnd64_destroy(pCtx);
+		return EXIT_FAILURE;
+	}
+
+	pthread_mutex_init(&fan.rLock, NULL);
+	pthread_cond_init(&fan.rSlotFree, NULL);
+
+	for (unsigned int i = 0; i < pOptions->iOpen; i++) {
+		aSlots[i].iFd = -1;
+	}
+
+	for (unsigned int i = 0; i < iNumThreads; i++) {
+
+		aWorkers[i].pFan = &fan;
+		aWorkers[i].pCtx = rnd64_clone(pCtx);
+
+		if (aWorkers[i].pCtx == NULL) {
+			fprintf(stderr, "\n%s: generator initialisation failed.\n\n", pFilename);
+
+			for (unsigned int j = 0; j < i; j++) {
+				rnd64_destroy(aWorkers[j].pCtx);
+			}
+
+			pthread_cond_destroy(&fan.rSlotFree);
+			pthread_mutex_destroy(&fan.rLock);
+			arenaDestroy(fan.pArena);
+			free(aSlots);
+			free(aWorkers);
+			free(aThreadID);
+			rnd64_destroy(pCtx);
+			return EXIT_FAILURE;
+		}
+	}
+
+	fStart = getTime();
+
+	for (unsigned int i = 0; i < iNumThreads; i++) {
+
+		if (pthread_create(&aThreadID[i], NULL, fanWorker, &aWorkers[i]) != 0) {
+			fprintf(stderr, "\n%s: writer thread cannot be started.\n\n", pFilename);
+			pthread_mutex_lock(&fan.rLock);
+			fan.iError = 1;
+			pthread_cond_broadcast(&fan.rSlotFree);
+			pthread_mutex_unlock(&fan.rLock);
+			break;
+		}
+
+		iStarted++;
+	}
+
+	for (unsigned int i = 0; i < iStarted; i++) {
+		pthread_join(aThreadID[i], NULL);
+	}
+
+	for (unsigned int i = 0; i < iNumThreads; i++) {
+		rnd64_destroy(aWorkers[i].pCtx);
+	}
+
+	fTime = getTime() - fStart;
+
+	/* close files left open by an error */
+	for (unsigned int i = 0; i < pOptions->iOpen; i++) {
+
+		if (aSlots[i].iFd >= 0) {
+			close(aSlots[i].iFd);
+		}
+	}
+
+	pthread_cond_destroy(&fan.rSlotFree);
+	pthread_mutex_destroy(&fan.rLock);
+	arenaDestroy(fan.pArena);
+	free(aSlots);
+	free(aWorkers);
+	free(aThreadID);
+	rnd64_destroy(pCtx);
+
+	uint64_t iTotalBytes = fan.iFilesDone * pOptions->iBytes;
+
+	printf("\n%s .. %s: %"PRIu64" of %"PRIu64" files generated\n\n", sFirst, sSecond, fan.iFilesDone, pOptions->iCount);
+	printf("size: %"PRIu64" bytes\n", iTotalBytes);
+	printf("time: %d s %d ms\n", (int) fTime, (int) (fTime * 1000) % 1000);
+
+	if (fTime > 0) {
+		printf("MB/s: %0.2f\n", (iTotalBytes * cMBRECIP * cMBRECIP) / fTime);
+		printf("files/s: %0.2f\n", fan.iFilesDone / fTime);
+	}
+
+	printf("\n");
+
+	return fan.iError ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+
+#elif _WIN64
+
+
+/**
+	* Write --count files of <size> bytes each (Linux only: positional writes).
+	*
+	* @param   Options_t* pOptions
+	* @return  int, EXIT_FAILURE
+*/
+
+int fanOut(Options_t const* pOptions) {
+
+	(void) pOptions;
+	fprintf(stderr, "\n%s: --count is not available on this platform.\n\n", pFilename);
+
+	return EXIT_FAILURE;
+}
+
+
+#endif
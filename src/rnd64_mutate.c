@@ -0,0 +1,630 @@
+/**
+	* RND64
+	* rnd64_mutate.c
+	*
+	* In-place mutation: --mutate <pct> changes a seeded random subset of an existing file's --block sized blocks,
+	* for rsync, incremental backup and block replication benchmarks, and writes a manifest of the changed extents.
+	*
+	* @author        Martin Latter
+	* @copyright     Martin Latter, April 2014
+	* @version       0.42 mt
+	* @license       GNU GPL version 3.0 (GPL v3); https://www.gnu.org/licenses/gpl-3.0.html
+	* @link          https://github.com/Tinram/RND64.git
+	*
+	* The subset is the head of the seeded block permutation (rnd64_randwrite.c), so only the mutated blocks are
+	* read, written or held in memory. Each chosen block gets one --ops mutation:
+	*     block    rewrite the whole block
+	*     range    rewrite a random byte range inside the block
+	*     insert   insert a new block before it (FALLOC_FL_INSERT_RANGE)
+	*     delete   remove the block (FALLOC_FL_COLLAPSE_RANGE)
+	* Rewrites run in parallel positional batches from --qd writers; inserts and deletes are extent operations,
+	* applied from the end of the file back so no data is moved. Manifest offsets are those of the mutated file.
+	*
+	* Example:       rnd64 --mutate 2% --block 4k --ops block,range,insert,delete f.bin
+*/
+
+
+#define _GNU_SOURCE /* O_DIRECT, fallocate() */
+
+#include "rnd64.h"
+
+#ifdef __linux
+	#include <fcntl.h>
+	#include <errno.h>
+	#include <sys/stat.h>
+	#include <linux/falloc.h>
+#endif
+
+
+#ifdef __linux
+
+
+/* constants */
+static uint64_t const cDIRECT_ALIGN = 4 * KB;  /* O_DIRECT offset and length alignment */
+static unsigned int const cQUEUE_DEPTH = 32;   /* default --qd */
+static uint64_t const cCLAIM = 64;             /* blocks claimed at a time: a positional batch */
+static uint64_t const cSTREAM = 1;             /* not the generation stream (0): new data differs from a same-seed file */
+
+
+/* structs */
+typedef enum {
+	MUTATE_BLOCK,
+	MUTATE_RANGE,
+	MUTATE_INSERT,
+	MUTATE_DELETE
+} MutateOp_t;
+
+static char const* const aOpNames[] = {"block", "range", "insert", "delete"};
+
+typedef struct {
+	Options_t const* pOptions;
+	rnd64_ctx_t const* pCtx;   /* cSTREAM */
+	Arena_t* pArena;
+	uint64_t* aBlocks;         /* mutated block numbers, ascending */
+	uint64_t iSelected;
+	uint64_t iSize;            /* before mutation */
+	uint64_t iBlocks;
+	uint64_t iKey;             /* seed: block choice and mutation details */
+	MutateOp_t aOps[4];        /* --ops */
+	unsigned int iOps;
+	int iFd;                   /* O_DIRECT where possible */
+	int iTailFd;               /* buffered: ranges, unaligned blocks, extent operations */
+	int iDirect;
+	uint64_t iNext;            /* next aBlocks index to claim */
+	int iError;
+} Mutate_t;
+
+typedef struct {
+	Mutate_t* pShared;
+	uint64_t iWritten;
+} MutateWorker_t;
+
+
+/**
+	* Write a buffer in full at an offset.
+	*
+	* @param   int iFd
+	* @param   uint8_t* pBuffer
+	* @param   size_t iLen
+	* @param   uint64_t iOffset
+	* @return  int, 0 on success, -1 on failure (message printed)
+*/
+
+static int writeAt(int iFd, uint8_t const* pBuffer, size_t iLen, uint64_t iOffset) {
+
+	size_t iDone = 0;
+
+	while (iDone < iLen) {
+
+		ssize_t iWritten = pwrite(iFd, pBuffer + iDone, iLen - iDone, (off_t) (iOffset + iDone));
+
+		if (iWritten < 0 && errno == EINTR) {
+			continue;
+		}
+
+		if (iWritten <= 0) {
+			fprintf(stderr, "\n%s: write failure at offset %"PRIu64" (%s).\n\n", pFilename, iOffset + iDone, strerror(errno));
+			return -1;
+		}
+
+		iDone += (size_t) iWritten;
+	}
+
+	return 0;
+}
+
+
+/**
+	* Mutation of a chosen block: a seeded pick from --ops; extent operations need a whole block before EOF.
+	*
+	* @param   Mutate_t* pShared
+	* @param   uint64_t iBlock
+	* @return  MutateOp_t
+*/
+
+static MutateOp_t blockOp(Mutate_t const* pShared, uint64_t iBlock) {
+
+	MutateOp_t iOp = pShared->aOps[mix64(pShared->iKey ^ iBlock) % pShared->iOps];
+
+	if (iOp == MUTATE_DELETE && iBlock >= pShared->iBlocks - 1) {
+		iOp = MUTATE_BLOCK; /* collapse cannot reach EOF */
+	}
+
+	return iOp;
+}
+
+
+/**
+	* Byte range rewritten by a range mutation: a seeded start and length inside the block.
+	*
+	* @param   Mutate_t* pShared
+	* @param   uint64_t iBlock
+	* @param   size_t iBlockLen
+	* @param   size_t* pStart, populated
+	* @param   size_t* pLen, populated
+	* @return  void
+*/
+
+static void blockRange(Mutate_t const* pShared, uint64_t iBlock, size_t iBlockLen, size_t* pStart, size_t* pLen) {
+
+	uint64_t iHash = mix64(pShared->iKey + ~iBlock);
+
+	*pStart = (size_t) (iHash % iBlockLen);
+	*pLen = 1 + (size_t) (mix64(iHash) % (iBlockLen - *pStart));
+}
+
+
+/**
+	* Thread function: claim batches of chosen blocks and rewrite their blocks and ranges.
+	*
+	* @param   void pointer st, MutateWorker_t struct
+	* @return  void* / null
+*/
+
+static void* mutateWorker(void* st) {
+
+	MutateWorker_t* pWorker = (MutateWorker_t*) st;
+	Mutate_t* pShared = pWorker->pShared;
+	uint64_t iBlockSize = pShared->pOptions->iBlock;
+	uint8_t* pBuffer = (uint8_t*) arenaAcquire(pShared->pArena);
+	rnd64_ctx_t* pCtx = rnd64_clone(pShared->pCtx);
+
+	if (pCtx == NULL) {
+		fprintf(stderr, "\n%s: generator initialisation failed.\n\n", pFilename);
+		__atomic_store_n(&pShared->iError, 1, __ATOMIC_RELAXED);
+	}
+
+	while (pCtx != NULL && ! __atomic_load_n(&pShared->iError, __ATOMIC_RELAXED)) {
+
+		uint64_t iFirst = __atomic_fetch_add(&pShared->iNext, cCLAIM, __ATOMIC_RELAXED);
+
+		if (iFirst >= pShared->iSelected) {
+			break;
+		}
+
+		uint64_t iLast = (iFirst + cCLAIM < pShared->iSelected) ? iFirst + cCLAIM : pShared->iSelected;
+
+		for (uint64_t i = iFirst; i < iLast; i++) {
+
+			uint64_t iBlock = pShared->aBlocks[i];
+			MutateOp_t iOp = blockOp(pShared, iBlock);
+			uint64_t iOffset = iBlock * iBlockSize;
+			size_t iLen = (pShared->iSize - iOffset < iBlockSize) ? (size_t) (pShared->iSize - iOffset) : (size_t) iBlockSize;
+
+			if (iOp == MUTATE_INSERT || iOp == MUTATE_DELETE) {
+				continue; /* extent operations: after the rewrites */
+			}
+
+			if (iOp == MUTATE_RANGE) {
+
+				size_t iStart = 0;
+
+				blockRange(pShared, iBlock, iLen, &iStart, &iLen);
+				iOffset += iStart;
+			}
+
+			rnd64_seek(pCtx, iOffset);
+
+			if (rnd64_fill(pCtx, pBuffer, iLen) != 0) {
+				fprintf(stderr, "\n%s: insufficient crypto random bytes available.\n\n", pFilename);
+				__atomic_store_n(&pShared->iError, 1, __ATOMIC_RELAXED);
+				break;
+			}
+
+			int iFd = (pShared->iDirect && iOp == MUTATE_BLOCK && iLen % cDIRECT_ALIGN == 0) ? pShared->iFd : pShared->iTailFd;
+
+			if (writeAt(iFd, pBuffer, iLen, iOffset) != 0) {
+				__atomic_store_n(&pShared->iError, 1, __ATOMIC_RELAXED);
+				break;
+			}
+
+			pWorker->iWritten += iLen;
+		}
+	}
+
+	rnd64_destroy(pCtx);
+	arenaRelease(pShared->pArena, pBuffer);
+
+	return NULL;
+}
+
+
+/**
+	* Apply inserts and deletes, last block first, so each block's original offset still holds.
+	*
+	* @param   Mutate_t* pShared
+	* @param   uint64_t* pWritten, inserted bytes added
+	* @return  int, 0 on success, -1 on failure (message printed)
+*/
+
+static int mutateExtents(Mutate_t* pShared, uint64_t* pWritten) {
+
+	uint64_t iBlockSize = pShared->pOptions->iBlock;
+	uint8_t* pBuffer = (uint8_t*) arenaAcquire(pShared->pArena);
+	rnd64_ctx_t* pCtx = rnd64_clone(pShared->pCtx);
+	int iResult = 0;
+
+	if (pCtx == NULL) {
+		fprintf(stderr, "\n%s: generator initialisation failed.\n\n", pFilename);
+		arenaRelease(pShared->pArena, pBuffer);
+		return -1;
+	}
+
+	for (uint64_t i = pShared->iSelected; i-- > 0;) {
+
+		uint64_t iBlock = pShared->aBlocks[i];
+		MutateOp_t iOp = blockOp(pShared, iBlock);
+		uint64_t iOffset = iBlock * iBlockSize;
+
+		if (iOp == MUTATE_BLOCK || iOp == MUTATE_RANGE) {
+			continue;
+		}
+
+		if (fallocate(pShared->iTailFd, (iOp == MUTATE_INSERT) ? FALLOC_FL_INSERT_RANGE : FALLOC_FL_COLLAPSE_RANGE, (off_t) iOffset, (off_t) iBlockSize) != 0) {
+			fprintf(stderr, "\n%s: %s at offset %"PRIu64" failed (%s): --ops insert / delete need ext4 or XFS.\n\n", pFilename, aOpNames[iOp], iOffset, strerror(errno));
+			iResult = -1;
+			break;
+		}
+
+		if (iOp == MUTATE_INSERT) {
+
+			/* the inserted range is a hole: fill it */
+			rnd64_seek(pCtx, iOffset);
+
+			if (rnd64_fill(pCtx, pBuffer, (size_t) iBlockSize) != 0) {
+				fprintf(stderr, "\n%s: insufficient crypto random bytes available.\n\n", pFilename);
+				iResult = -1;
+				break;
+			}
+
+			if (writeAt(pShared->iDirect ? pShared->iFd : pShared->iTailFd, pBuffer, (size_t) iBlockSize, iOffset) != 0) {
+				iResult = -1;
+				break;
+			}
+
+			*pWritten += iBlockSize;
+		}
+	}
+
+	rnd64_destroy(pCtx);
+	arenaRelease(pShared->pArena, pBuffer);
+
+	return iResult;
+}
+
+
+/**
+	* Write the manifest: one line per mutation, ascending, at offsets in the mutated file.
+	*
+	* @param   Mutate_t* pShared
+	* @param   char* sManifest
+	* @param   uint64_t iNewSize
+	* @return  int, 0 on success, -1 on failure (message printed)
+*/
+
+static int writeManifest(Mutate_t const* pShared, char const* sManifest, uint64_t iNewSize) {
+
+	uint64_t iBlockSize = pShared->pOptions->iBlock;
+	int64_t iShift = 0; /* inserted less deleted bytes below the current block */
+	FILE* pManifest = fopen(sManifest, "w");
+
+	if (pManifest == NULL) {
+		fprintf(stderr, "\n%s: manifest '%s' cannot be written (%s).\n\n", pFilename, sManifest, strerror(errno));
+		return -1;
+	}
+
+	setvbuf(pManifest, NULL, _IOFBF, 1024 * KB);
+
+	fprintf(pManifest, "# rnd64 --mutate %s  size: %"PRIu64" -> %"PRIu64"  block: %"PRIu64"  seed: 0x%016"PRIx64"\n", pShared->pOptions->sOutput, pShared->iSize, iNewSize, iBlockSize, pShared->iKey);
+	fprintf(pManifest, "# offset length op\n");
+
+	for (uint64_t i = 0; i < pShared->iSelected; i++) {
+
+		uint64_t iBlock = pShared->aBlocks[i];
+		MutateOp_t iOp = blockOp(pShared, iBlock);
+		uint64_t iOffset = iBlock * iBlockSize;
+		size_t iLen = (pShared->iSize - iOffset < iBlockSize) ? (size_t) (pShared->iSize - iOffset) : (size_t) iBlockSize;
+
+		if (iOp == MUTATE_RANGE) {
+
+			size_t iStart = 0;
+
+			blockRange(pShared, iBlock, iLen, &iStart, &iLen);
+			iOffset += iStart;
+		}
+		else if (iOp != MUTATE_BLOCK) {
+			iLen = (size_t) iBlockSize;
+		}
+
+		fprintf(pManifest, "%"PRIu64" %zu %s\n", (uint64_t) ((int64_t) iOffset + iShift), iLen, aOpNames[iOp]);
+
+		if (iOp == MUTATE_INSERT) {
+			iShift += (int64_t) iBlockSize;
+		}
+		else if (iOp == MUTATE_DELETE) {
+			iShift -= (int64_t) iBlockSize;
+		}
+	}
+
+	if (fclose(pManifest) != 0) {
+		fprintf(stderr, "\n%s: manifest '%s' write failure (%s).\n\n", pFilename, sManifest, strerror(errno));
+		return -1;
+	}
+
+	return 0;
+}
+
+
+/**
+	* qsort() comparator: ascending block numbers.
+	*
+	* @param   void* pA
+	* @param   void* pB
+	* @return  int
+*/
+
+static int compareBlocks(void const* pA, void const* pB) {
+
+	uint64_t iA = *(uint64_t const*) pA;
+	uint64_t iB = *(uint64_t const*) pB;
+
+	return (iA > iB) - (iA < iB);
+}
+
+
+/**
+	* Parse an --ops list, e.g. block,range,insert,delete.
+	*
+	* @param   char* sOps
+	* @param   Mutate_t* pShared, aOps and iOps populated
+	* @return  int, 0 on success, -1 on error (message printed)
+*/
+
+static int parseOps(char const* sOps, Mutate_t* pShared) {
+
+	char const* pStart = sOps;
+
+	for (;;) {
+
+		char const* pEnd = strchr(pStart, ',');
+		size_t iLen = (pEnd != NULL) ? (size_t) (pEnd - pStart) : strlen(pStart);
+		unsigned int iOp = 0;
+
+		while (iOp < 4 && (strlen(aOpNames[iOp]) != iLen || strncmp(pStart, aOpNames[iOp], iLen) != 0)) {
+			iOp++;
+		}
+
+		if (iOp == 4 || pShared->iOps == 4) {
+			fprintf(stderr, "\n%s: --ops takes block, range, insert, delete; comma-separated\n\n", pFilename);
+			return -1;
+		}
+
+		pShared->aOps[pShared->iOps++] = (MutateOp_t) iOp;
+
+		if (pEnd == NULL) {
+			break;
+		}
+
+		pStart = pEnd + 1;
+	}
+
+	return 0;
+}
+
+
+/**
+	* Mutate a seeded random --mutate percentage of [file]'s blocks in place.
+	*
+	* @param   Options_t* pOptions
+	* @return  int, EXIT_SUCCESS / EXIT_FAILURE
+*/
+
+int mutate(Options_t const* pOptions) {
+
+	unsigned int iWriters = (pOptions->iQueueDepth > 0) ? pOptions->iQueueDepth : cQUEUE_DEPTH;
+	uint64_t iBlockSize = pOptions->iBlock;
+	uint64_t iWritten = 0;
+	int iExtents = 0;
+	int iResult = EXIT_SUCCESS;
+	struct stat rStat;
+	Mutate_t shared;
+
+	memset(&shared, 0, sizeof(shared));
+	shared.pOptions = pOptions;
+
+	if (parseOps((pOptions->sOps != NULL) ? pOptions->sOps : "block", &shared) != 0) {
+		return EXIT_FAILURE;
+	}
+
+	for (unsigned int i = 0; i < shared.iOps; i++) {
+		iExtents |= (shared.aOps[i] == MUTATE_INSERT || shared.aOps[i] == MUTATE_DELETE);
+	}
+
+	if (stat(pOptions->sOutput, &rStat) != 0 || ! S_ISREG(rStat.st_mode) || rStat.st_size == 0) {
+		fprintf(stderr, "\n%s: '%s' is not an existing, non-empty file.\n\n", pFilename, pOptions->sOutput);
+		return EXIT_FAILURE;
+	}
+
+	if (iExtents && iBlockSize % (uint64_t) rStat.st_blksize != 0) {
+		fprintf(stderr, "\n%s: --ops insert / delete need a --block multiple of the filesystem block (%u bytes).\n\n", pFilename, (unsigned int) rStat.st_blksize);
+		return EXIT_FAILURE;
+	}
+
+	shared.iSize = (uint64_t) rStat.st_size;
+	shared.iBlocks = (shared.iSize + iBlockSize - 1) / iBlockSize;
+	shared.iSelected = (uint64_t) ((double) shared.iBlocks * pOptions->fMutate / 100 + 0.5);
+
+	if (shared.iSelected == 0) {
+		shared.iSelected = 1;
+	}
+	else if (shared.iSelected > shared.iBlocks) {
+		shared.iSelected = shared.iBlocks;
+	}
+
+	if (iWriters > (shared.iSelected + cCLAIM - 1) / cCLAIM) {
+		iWriters = (unsigned int) ((shared.iSelected + cCLAIM - 1) / cCLAIM);
+	}
+
+	shared.iDirect = (iBlockSize % cDIRECT_ALIGN == 0);
+	shared.iFd = open(pOptions->sOutput, O_WRONLY | (shared.iDirect ? O_DIRECT : 0));
+
+	if (shared.iFd < 0 && shared.iDirect && errno == EINVAL) { /* filesystem without O_DIRECT, e.g. tmpfs */
+		shared.iDirect = 0;
+		shared.iFd = open(pOptions->sOutput, O_WRONLY);
+	}
+
+	shared.iTailFd = (shared.iFd >= 0) ? open(pOptions->sOutput, O_WRONLY) : -1;
+
+	if (shared.iFd < 0 || shared.iTailFd < 0) {
+		fprintf(stderr, "\n%s: '%s' cannot be opened for writing (%s).\n\n", pFilename, pOptions->sOutput, strerror(errno));
+
+		if (shared.iFd >= 0) {
+			close(shared.iFd);
+		}
+
+		return EXIT_FAILURE;
+	}
+
+	rnd64_ctx_t* pCtx = rnd64_create(pOptions->iMode, pOptions->iEngine, pOptions->iSeed);
+
+	pthread_t* aThreadID = (pthread_t*) calloc(iWriters, sizeof(pthread_t));
+	MutateWorker_t* aWorkers = (MutateWorker_t*) calloc(iWriters, sizeof(MutateWorker_t));
+	unsigned int iStarted = 0;
+
+	shared.aBlocks = (uint64_t*) malloc(shared.iSelected * sizeof(uint64_t));
+	shared.pArena = arenaCreate((size_t) iBlockSize, iWriters + 1);
+
+	if (pCtx == NULL || shared.aBlocks == NULL || shared.pArena == NULL || aThreadID == NULL || aWorkers == NULL) {
+		fprintf(stderr, "\n%s: %s.\n\n", pFilename, (pCtx == NULL) ? "secure data generation unavailable" : "insufficient memory for the mutation list");
+		arenaDestroy(shared.pArena);
+		free(aWorkers);
+		free(aThreadID);
+		free(shared.aBlocks);
+		rnd64_destroy(pCtx);
+		close(shared.iTailFd);
+		close(shared.iFd);
+		return EXIT_FAILURE;
+	}
+
+	rnd64_stream(pCtx, cSTREAM);
+	shared.pCtx = pCtx;
+	shared.iKey = rnd64_seed(pCtx);
+
+	printf("\nmutate: %s  %"PRIu64" bytes  %s  writers: %u\n", pOptions->sOutput, shared.iSize, shared.iDirect ? "O_DIRECT" : "buffered", iWriters);
+	printf("seed: 0x%016"PRIx64"\n", shared.iKey);
+
+	double fStart = getTime();
+
+	/* the chosen blocks: the head of the seeded permutation, in file order for sequential batches */
+	Permutation_t perm;
+
+	permutationInit(&perm, shared.iBlocks, shared.iKey);
+
+	for (uint64_t i = 0; i < shared.iSelected; i++) {
+		shared.aBlocks[i] = permute(&perm, i);
+	}
+
+	qsort(shared.aBlocks, shared.iSelected, sizeof(uint64_t), compareBlocks);
+
+	for (unsigned int i = 0; i < iWriters; i++) {
+
+		aWorkers[i].pShared = &shared;
+		aWorkers[i].iWritten = 0;
+
+		/* stop the writers already running: no manifest for a partial mutation */
+		if (pthread_create(&aThreadID[i], NULL, mutateWorker, &aWorkers[i]) != 0) {
+			fprintf(stderr, "\n%s: writer thread cannot be started.\n\n", pFilename);
+			__atomic_store_n(&shared.iError, 1, __ATOMIC_RELAXED);
+			break;
+		}
+
+		iStarted++;
+	}
+
+	for (unsigned int i = 0; i < iStarted; i++) {
+		pthread_join(aThreadID[i], NULL);
+		iWritten += aWorkers[i].iWritten;
+	}
+
+	if (shared.iError || (iExtents && mutateExtents(&shared, &iWritten) != 0)) {
+		iResult = EXIT_FAILURE;
+	}
+
+	if (fdatasync(shared.iFd) != 0 || fdatasync(shared.iTailFd) != 0) {
+		fprintf(stderr, "\n%s: sync failure (%s).\n\n", pFilename, strerror(errno));
+		iResult = EXIT_FAILURE;
+	}
+
+	double fTime = getTime() - fStart;
+	uint64_t aCounts[4] = {0, 0, 0, 0};
+	uint64_t iNewSize = shared.iSize;
+
+	if (fstat(shared.iTailFd, &rStat) == 0) {
+		iNewSize = (uint64_t) rStat.st_size;
+	}
+
+	for (uint64_t i = 0; i < shared.iSelected; i++) {
+		aCounts[blockOp(&shared, shared.aBlocks[i])]++;
+	}
+
+	printf("\nmutated: %"PRIu64" of %"PRIu64" blocks of %"PRIu64" bytes (%0.2f%%)\n", shared.iSelected, shared.iBlocks, iBlockSize, 100.0 * shared.iSelected / shared.iBlocks);
+	printf("  block: %"PRIu64"  range: %"PRIu64"  insert: %"PRIu64"  delete: %"PRIu64"\n", aCounts[MUTATE_BLOCK], aCounts[MUTATE_RANGE], aCounts[MUTATE_INSERT], aCounts[MUTATE_DELETE]);
+	printf("written: %"PRIu64" bytes  size: %"PRIu64" bytes\n", iWritten, iNewSize);
+	printf("time: %d s %d ms\n", (int) fTime, (int) (fTime * 1000) % 1000);
+
+	if (fTime > 0) {
+		printf("MB/s: %0.2f\n", (iWritten * cMBRECIP * cMBRECIP) / fTime);
+	}
+
+	if (iResult == EXIT_SUCCESS) {
+
+		char sDefault[strlen(pOptions->sOutput) + sizeof(".manifest")];
+		char const* sManifest = pOptions->sManifest;
+
+		if (sManifest == NULL) {
+			snprintf(sDefault, sizeof(sDefault), "%s.manifest", pOptions->sOutput);
+			sManifest = sDefault;
+		}
+
+		if (writeManifest(&shared, sManifest, iNewSize) != 0) {
+			iResult = EXIT_FAILURE;
+		}
+		else {
+			printf("manifest: %s\n", sManifest);
+		}
+	}
+
+	printf("\n");
+
+	arenaDestroy(shared.pArena);
+	free(aWorkers);
+	free(aThreadID);
+	free(shared.aBlocks);
+	rnd64_destroy(pCtx);
+	close(shared.iTailFd);
+	close(shared.iFd);
+
+	return iResult;
+}
+
+
+#elif _WIN64
+
+
+/**
+	* Mutate a file in place (Linux only: positional writes, extent insert / collapse).
+	*
+	* @param   Options_t* pOptions
+	* @return  int, EXIT_FAILURE
+*/
+
+int mutate(Options_t const* pOptions) {
+
+	(void) pOptions;
+	fprintf(stderr, "\n%s: --mutate is not available on this platform.\n\n", pFilename);
+
+	return EXIT_FAILURE;
+}
+
+
+#endif
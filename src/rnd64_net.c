@@ -0,0 +1,580 @@
+/**
+	* RND64
+	* rnd64_net.c
+	*
+	* Network sink: send <size> bytes over -P parallel TCP connections or UDP flows, replacing rnd64 | pv | nc.
+	*
+	* @author        Martin Latter
+	* @copyright     Martin Latter, April 2014
+	* @version       0.42 mt
+	* @license       GNU GPL version 3.0 (GPL v3); https://www.gnu.org/licenses/gpl-3.0.html
+	* @link          https://github.com/Tinram/RND64.git
+	*
+	* Each connection has its own thread, socket and generator. With --zerocopy, TCP sends use MSG_ZEROCOPY
+	* from a ring of buffers: a buffer is refilled only after the kernel reports its send complete.
+	* UDP datagrams are batched with sendmmsg().
+	*
+	* Loopback test:    nc -lk -p 3000 > /dev/null &    rnd64 -a 4g --tcp 127.0.0.1:3000 -P 4
+*/
+
+
+#define _GNU_SOURCE /* sendmmsg() */
+
+#include "rnd64.h"
+
+#ifdef __linux
+	#include <errno.h>
+	#include <poll.h>
+	#include <netdb.h>
+	#include <sys/socket.h>
+	#include <netinet/in.h>
+	#include <linux/errqueue.h>
+#endif
+
+
+#ifdef __linux
+
+
+/* defines */
+#define ZC_RING 8                 /* zerocopy buffers in flight per connection */
+#define UDP_BATCH 64              /* datagrams per sendmmsg() */
+
+
+/* constants */
+static unsigned int const cDGRAM = 1472; /* UDP payload fitting a 1500 byte MTU */
+
+
+/* structs */
+typedef struct {
+	Options_t const* pOptions;
+	struct addrinfo* pAddr;
+	rnd64_ctx_t* pCtx;
+	Arena_t* pArena;           /* one send buffer (ring) per connection */
+	unsigned int iConn;
+	uint64_t iBytes;           /* to send */
+	uint64_t iSent;            /* results */
+	uint64_t iDropped;         /* UDP datagrams refused by the socket */
+	double fTime;
+	int iZeroCopy;             /* zerocopy in use (requested and accepted) */
+	int iError;
+} NetWorker_t;
+
+typedef struct {
+	uint32_t iIssued;          /* zerocopy send() calls made */
+	uint32_t iCompleted;       /* sends reported complete */
+	uint32_t aLast[ZC_RING];   /* iIssued after the last send from each buffer */
+} ZeroCopy_t;
+
+
+/**
+	* Split host:port ([v6addr]:port) and resolve.
+	*
+	* @param   char* sTarget
+	* @param   int iSockType, SOCK_STREAM / SOCK_DGRAM
+	* @return  struct addrinfo*, NULL on failure (message printed)
+*/
+
+static struct addrinfo* resolveTarget(char const* sTarget, int iSockType) {
+
+	char sHost[256];
+	char const* pPort = strrchr(sTarget, ':');
+	size_t iHostLen = 0;
+	struct addrinfo hints;
+	struct addrinfo* pAddr = NULL;
+	int iResult = 0;
+
+	if (pPort == NULL || pPort == sTarget || pPort[1] == '\0') {
+		fprintf(stderr, "\n%s: network target must be host:port  e.g. 192.168.1.20:3000\n\n", pFilename);
+		return NULL;
+	}
+
+	if (sTarget[0] == '[' && pPort[-1] == ']') {
+		sTarget++;
+		iHostLen = (size_t) (pPort - sTarget) - 1;
+	}
+	else {
+		iHostLen = (size_t) (pPort - sTarget);
+	}
+
+	if (iHostLen >= sizeof(sHost)) {
+		fprintf(stderr, "\n%s: host name too long.\n\n", pFilename);
+		return NULL;
+	}
+
+	memcpy(sHost, sTarget, iHostLen);
+	sHost[iHostLen] = '\0';
+
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = iSockType;
+
+	iResult = getaddrinfo(sHost, pPort + 1, &hints, &pAddr);
+
+	if (iResult != 0) {
+		fprintf(stderr, "\n%s: cannot resolve '%s' (%s).\n\n", pFilename, sHost, gai_strerror(iResult));
+		return NULL;
+	}
+
+	return pAddr;
+}
+
+
+/**
+	* Collect zerocopy completion notifications from the socket error queue.
+	*
+	* @param   int iSock
+	* @param   ZeroCopy_t* pZc
+	* @param   int iWait, block until at least one notification arrives
+	* @return  int, 0 on success, -1 on socket error
+*/
+
+static int reapZeroCopy(int iSock, ZeroCopy_t* pZc, int iWait) {
+
+	char aControl[128];
+	struct msghdr msg;
+	struct pollfd pfd;
+
+	for (;;) {
+
+		memset(&msg, 0, sizeof(msg));
+		msg.msg_control = aControl;
+		msg.msg_controllen = sizeof(aControl);
+
+		if (recvmsg(iSock, &msg, MSG_ERRQUEUE) < 0) {
+
+			if (errno == EAGAIN || errno == EWOULDBLOCK) {
+
+				if ( ! iWait) {
+					return 0;
+				}
+
+				/* an empty poll mask still reports POLLERR: a notification is queued */
+				pfd.fd = iSock;
+				pfd.events = 0;
+				poll(&pfd, 1, 1000);
+				continue;
+			}
+
+			return -1;
+		}
+
+		for (struct cmsghdr* pCmsg = CMSG_FIRSTHDR(&msg); pCmsg != NULL; pCmsg = CMSG_NXTHDR(&msg, pCmsg)) {
+
+			struct sock_extended_err* pErr = (struct sock_extended_err*) CMSG_DATA(pCmsg);
+
+			if (pErr->ee_errno == 0 && pErr->ee_origin == SO_EE_ORIGIN_ZEROCOPY) {
+
+				/* notifications arrive in order as ranges [ee_info, ee_data] of send() numbers */
+				if (pErr->ee_data + 1 > pZc->iCompleted) {
+					pZc->iCompleted = pErr->ee_data + 1;
+				}
+			}
+		}
+
+		iWait = 0;
+	}
+}
+
+
+/**
+	* Send a buffer completely on a stream socket.
+	*
+	* @param   int iSock
+	* @param   uint8_t* pBuf
+	* @param   size_t iLen
+	* @param   ZeroCopy_t* pZc, NULL for copying sends
+	* @return  int, 0 on success, -1 on failure
+*/
+
+static int sendAll(int iSock, uint8_t const* pBuf, size_t iLen, ZeroCopy_t* pZc) {
+
+	while (iLen > 0) {
+
+		ssize_t iSent = send(iSock, pBuf, iLen, (pZc != NULL) ? MSG_ZEROCOPY : 0);
+
+		if (iSent < 0) {
+
+			if (errno == EINTR) {
+				continue;
+			}
+
+			/* optmem exhausted by outstanding zerocopy sends: reap and retry */
+			if (errno == ENOBUFS && pZc != NULL) {
+				reapZeroCopy(iSock, pZc, 1);
+				continue;
+			}
+
+			return -1;
+		}
+
+		if (pZc != NULL) {
+			pZc->iIssued++;
+		}
+
+		pBuf += iSent;
+		iLen -= (size_t) iSent;
+	}
+
+	return 0;
+}
+
+
+/**
+	* Thread function: one TCP connection.
+	*
+	* @param   void pointer st, NetWorker_t struct
+	* @return  void* / null
+*/
+
+static void* tcpWorker(void* st) {
+
+	NetWorker_t* pWorker = (NetWorker_t*) st;
+	unsigned int iRing = pWorker->pOptions->iZeroCopy ? ZC_RING : 1;
+	uint8_t* pBuffers = (uint8_t*) arenaAcquire(pWorker->pArena);
+	ZeroCopy_t zc;
+	int iSock = -1;
+	double fStart = 0;
+
+	memset(&zc, 0, sizeof(zc));
+
+	iSock = socket(pWorker->pAddr->ai_family, SOCK_STREAM, 0);
+
+	if (pBuffers == NULL || iSock < 0 || connect(iSock, pWorker->pAddr->ai_addr, pWorker->pAddr->ai_addrlen) != 0) {
+		fprintf(stderr, "\n%s: connection %u failed (%s).\n\n", pFilename, pWorker->iConn, strerror(errno));
+		pWorker->iError = 1;
+		goto exit;
+	}
+
+	if (pWorker->pOptions->iZeroCopy) {
+
+		int iOne = 1;
+
+		pWorker->iZeroCopy = (setsockopt(iSock, SOL_SOCKET, SO_ZEROCOPY, &iOne, sizeof(iOne)) == 0);
+
+		if ( ! pWorker->iZeroCopy) {
+			iRing = 1;
+		}
+	}
+
+	fStart = getTime();
+
+	for (uint64_t i = 0; pWorker->iSent < pWorker->iBytes; i++) {
+
+		unsigned int iSlot = (unsigned int) (i % iRing);
+		uint8_t* pBuffer = pBuffers + (size_t) iSlot * cBUFFER;
+		uint64_t iLeft = pWorker->iBytes - pWorker->iSent;
+		size_t iLen = (iLeft < cBUFFER) ? (size_t) iLeft : cBUFFER;
+
+		/* the kernel may still be reading this buffer */
+		while (pWorker->iZeroCopy && zc.iCompleted < zc.aLast[iSlot]) {
+
+			if (reapZeroCopy(iSock, &zc, 1) != 0) {
+				break;
+			}
+		}
+
+		if (rnd64_fill(pWorker->pCtx, pBuffer, iLen) != 0) {
+			fprintf(stderr, "\n%s: insufficient crypto random bytes available.\n\n", pFilename);
+			pWorker->iError = 1;
+			break;
+		}
+
+		if (sendAll(iSock, pBuffer, iLen, pWorker->iZeroCopy ? &zc : NULL) != 0) {
+			fprintf(stderr, "\n%s: connection %u send failure (%s).\n\n", pFilename, pWorker->iConn, strerror(errno));
+			pWorker->iError = 1;
+			break;
+		}
+
+		zc.aLast[iSlot] = zc.iIssued;
+		pWorker->iSent += iLen;
+	}
+
+	while (pWorker->iZeroCopy && ! pWorker->iError && zc.iCompleted < zc.iIssued) {
+
+		if (reapZeroCopy(iSock, &zc, 1) != 0) {
+			break;
+		}
+	}
+
+	shutdown(iSock, SHUT_WR);
+	pWorker->fTime = getTime() - fStart;
+
+	exit:
+
+		if (iSock >= 0) {
+			close(iSock);
+		}
+
+		arenaRelease(pWorker->pArena, pBuffers);
+
+		return NULL;
+}
+
+
+/**
+	* Thread function: one UDP flow, MTU-sized datagrams batched with sendmmsg().
+	*
+	* @param   void pointer st, NetWorker_t struct
+	* @return  void* / null
+*/
+
+static void* udpWorker(void* st) {
+
+	NetWorker_t* pWorker = (NetWorker_t*) st;
+	size_t iBatchBytes = (size_t) cDGRAM * UDP_BATCH;
+	uint8_t* pBuffer = (uint8_t*) arenaAcquire(pWorker->pArena);
+	struct mmsghdr aMsgs[UDP_BATCH];
+	struct iovec aIov[UDP_BATCH];
+	int iSock = -1;
+	uint64_t iDone = 0;
+	double fStart = 0;
+
+	iSock = socket(pWorker->pAddr->ai_family, SOCK_DGRAM, 0);
+
+	if (pBuffer == NULL || iSock < 0 || connect(iSock, pWorker->pAddr->ai_addr, pWorker->pAddr->ai_addrlen) != 0) {
+		fprintf(stderr, "\n%s: UDP flow %u failed (%s).\n\n", pFilename, pWorker->iConn, strerror(errno));
+		pWorker->iError = 1;
+		goto exit;
+	}
+
+	fStart = getTime();
+
+	while (iDone < pWorker->iBytes) {
+
+		uint64_t iLeft = pWorker->iBytes - iDone;
+		size_t iLen = (iLeft < iBatchBytes) ? (size_t) iLeft : iBatchBytes;
+		unsigned int iDgrams = (unsigned int) ((iLen + cDGRAM - 1) / cDGRAM);
+
+		if (rnd64_fill(pWorker->pCtx, pBuffer, iLen) != 0) {
+			fprintf(stderr, "\n%s: insufficient crypto random bytes available.\n\n", pFilename);
+			pWorker->iError = 1;
+			break;
+		}
+
+		memset(aMsgs, 0, sizeof(struct mmsghdr) * iDgrams);
+
+		for (unsigned int d = 0; d < iDgrams; d++) {
+			aIov[d].iov_base = pBuffer + (size_t) d * cDGRAM;
+			aIov[d].iov_len = (d == iDgrams - 1) ? iLen - (size_t) d * cDGRAM : cDGRAM;
+			aMsgs[d].msg_hdr.msg_iov = &aIov[d];
+			aMsgs[d].msg_hdr.msg_iovlen = 1;
+		}
+
+		unsigned int d = 0;
+
+		while (d < iDgrams) {
+
+			int iResult = sendmmsg(iSock, aMsgs + d, iDgrams - d, 0);
+
+			if (iResult < 0) {
+
+				if (errno == EINTR) {
+					continue;
+				}
+
+				/* no listener (ICMP port unreachable) or full device queue: the rest of the batch is lost, as UDP would lose it */
+				if (errno == ECONNREFUSED || errno == ENOBUFS) {
+					pWorker->iDropped += iDgrams - d;
+					break;
+				}
+
+				fprintf(stderr, "\n%s: UDP flow %u send failure (%s).\n\n", pFilename, pWorker->iConn, strerror(errno));
+				pWorker->iError = 1;
+				goto exit;
+			}
+
+			d += (unsigned int) iResult;
+		}
+
+		pWorker->iSent += (d == iDgrams) ? iLen : (size_t) d * cDGRAM;
+		iDone += iLen;
+	}
+
+	pWorker->fTime = getTime() - fStart;
+
+	exit:
+
+		if (iSock >= 0) {
+			close(iSock);
+		}
+
+		arenaRelease(pWorker->pArena, pBuffer);
+
+		return NULL;
+}
+
+
+/**
+	* Send <size> bytes to --tcp / --udp host:port over -P connections, with per-connection rates.
+	*
+	* @param   Options_t* pOptions
+	* @return  int, EXIT_SUCCESS / EXIT_FAILURE
+*/
+
+int netSend(Options_t const* pOptions) {
+
+	int iUdp = (pOptions->sUdp != NULL);
+	char const* sTarget = iUdp ? pOptions->sUdp : pOptions->sTcp;
+	unsigned int iConns = pOptions->iStreams;
+	uint64_t iConnBytes = pOptions->iBytes / iConns;
+	uint64_t iTotalSent = 0;
+	int iError = 0;
+	double fStart = 0;
+	double fTime = 0;
+
+	unsigned int iStarted = 0;
+
+	struct addrinfo* pAddr = resolveTarget(sTarget, iUdp ? SOCK_DGRAM : SOCK_STREAM);
+
+	if (pAddr == NULL) {
+		return EXIT_FAILURE;
+	}
+
+	/* per-connection state sized by -P: heap, not stack */
+	pthread_t* rThreadID = (pthread_t*) calloc(iConns, sizeof(pthread_t));
+	NetWorker_t* aWorkers = (NetWorker_t*) calloc(iConns, sizeof(NetWorker_t));
+
+	if (rThreadID == NULL || aWorkers == NULL) {
+		fprintf(stderr, "\n%s: insufficient memory for %u connections.\n\n", pFilename, iConns);
+		free(aWorkers);
+		free(rThreadID);
+		freeaddrinfo(pAddr);
+		return EXIT_FAILURE;
+	}
+
+	rnd64_ctx_t* pCtx = rnd64_create(pOptions->iMode, pOptions->iEngine, pOptions->iSeed);
+
+	if (pCtx == NULL) {
+		fprintf(stderr, "\n%s: secure data generation unavailable.\n\n", pFilename);
+		free(aWorkers);
+		free(rThreadID);
+		freeaddrinfo(pAddr);
+		return EXIT_FAILURE;
+	}
+
+	size_t iSendBuffer = iUdp ? (size_t) cDGRAM * UDP_BATCH : (size_t) cBUFFER * (pOptions->iZeroCopy ? ZC_RING : 1);
+	Arena_t* pArena = arenaCreate(iSendBuffer, iConns);
+
+	if (pArena == NULL) {
+		fprintf(stderr, "\n%s: insufficient memory for %u buffers of %zu bytes.\n\n", pFilename, iConns, iSendBuffer);
+		rnd64_destroy(pCtx);
+		free(aWorkers);
+		free(rThreadID);
+		freeaddrinfo(pAddr);
+		return EXIT_FAILURE;
+	}
+
+	for (unsigned int i = 0; i < iConns; i++) {
+
+		memset(&aWorkers[i], 0, sizeof(NetWorker_t));
+		aWorkers[i].pOptions = pOptions;
+		aWorkers[i].pAddr = pAddr;
+		aWorkers[i].pArena = pArena;
+		aWorkers[i].iConn = i + 1;
+		aWorkers[i].iBytes = (i == iConns - 1) ? pOptions->iBytes - i * iConnBytes : iConnBytes;
+		aWorkers[i].pCtx = rnd64_clone(pCtx);
+
+		if (aWorkers[i].pCtx == NULL) {
+			fprintf(stderr, "\n%s: generator initialisation failed.\n\n", pFilename);
+
+			for (unsigned int j = 0; j < i; j++) {
+				rnd64_destroy(aWorkers[j].pCtx);
+			}
+
+			arenaDestroy(pArena);
+			rnd64_destroy(pCtx);
+			free(aWorkers);
+			free(rThreadID);
+			freeaddrinfo(pAddr);
+			return EXIT_FAILURE;
+		}
+
+		rnd64_stream(aWorkers[i].pCtx, i);
+	}
+
+	fStart = getTime();
+
+	for (unsigned int i = 0; i < iConns; i++) {
+
+		if (pthread_create(&rThreadID[i], NULL, iUdp ? udpWorker : tcpWorker, &aWorkers[i]) != 0) {
+			fprintf(stderr, "\n%s: sender thread cannot be started.\n\n", pFilename);
+			break;
+		}
+
+		iStarted++;
+	}
+
+	/* connections without a thread send nothing: reported as failed */
+	for (unsigned int i = iStarted; i < iConns; i++) {
+		aWorkers[i].iError = 1;
+	}
+
+	for (unsigned int i = 0; i < iStarted; i++) {
+		pthread_join(rThreadID[i], NULL);
+	}
+
+	for (unsigned int i = 0; i < iConns; i++) {
+		rnd64_destroy(aWorkers[i].pCtx);
+	}
+
+	fTime = getTime() - fStart;
+
+	fprintf(stderr, "\n%s %s, %u %s%s\n\n", iUdp ? "UDP" : "TCP", sTarget, iConns, iUdp ? "flow(s)" : "connection(s)", aWorkers[0].iZeroCopy ? ", zerocopy" : "");
+
+	for (unsigned int i = 0; i < iConns; i++) {
+
+		NetWorker_t* pWorker = &aWorkers[i];
+
+		fprintf(stderr, "  [%2u]  %"PRIu64" bytes  %0.2f MB/s%s", pWorker->iConn, pWorker->iSent,
+			(pWorker->fTime > 0) ? (pWorker->iSent * cMBRECIP * cMBRECIP) / pWorker->fTime : 0.0,
+			pWorker->iError ? "  (failed)" : "");
+
+		if (pWorker->iDropped > 0) {
+			fprintf(stderr, "  %"PRIu64" datagrams dropped", pWorker->iDropped);
+		}
+
+		fprintf(stderr, "\n");
+
+		iTotalSent += pWorker->iSent;
+		iError |= pWorker->iError;
+	}
+
+	fprintf(stderr, "\nsize: %"PRIu64" bytes\n", iTotalSent);
+	fprintf(stderr, "time: %d s %d ms\n", (int) fTime, (int) (fTime * 1000) % 1000);
+
+	if (fTime > 0) {
+		fprintf(stderr, "MB/s: %0.2f\n", (iTotalSent * cMBRECIP * cMBRECIP) / fTime);
+	}
+
+	fprintf(stderr, "\n");
+
+	freeaddrinfo(pAddr);
+	rnd64_destroy(pCtx);
+	arenaDestroy(pArena);
+	free(aWorkers);
+	free(rThreadID);
+
+	return iError ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+
+#elif _WIN64
+
+
+/**
+	* Send <size> bytes to --tcp / --udp host:port (Linux only).
+	*
+	* @param   Options_t* pOptions
+	* @return  int, EXIT_FAILURE
+*/
+
+int netSend(Options_t const* pOptions) {
+
+	(void) pOptions;
+	fprintf(stderr, "\n%s: --tcp / --udp are not available on this platform.\n\n", pFilename);
+
+	return EXIT_FAILURE;
+}
+
+
+#endif
@@ -0,0 +1,644 @@
+/**
+	* RND64
+	* rnd64_output.c
+	*
+	* Ordered output stage: generator threads fill numbered chunks in any order, one writer thread writes them
+	* to a descriptor in sequence, gathering consecutive ready chunks into a single writev().
+	*
+	* @author        Martin Latter
+	* @copyright     Martin Latter, April 2014
+	* @version       0.42 mt
+	* @license       GNU GPL version 3.0 (GPL v3); https://www.gnu.org/licenses/gpl-3.0.html
+	* @link          https://github.com/Tinram/RND64.git
+	*
+	* Chunk n lives in slot n % slots of an arena. A producer blocks in outputAcquire() until chunk n - slots has
+	* been written, so at most slots chunks are ever queued and a slow consumer paces generation.
+	*
+	* streamRun() feeds the stage from -t generator threads, for streamOut() and the --tune calibration.
+	* streamOut() is the Linux stdout and [file] stream: a pipe is enlarged towards pipe-max-size, the stream
+	* comes out in order (so -s output does not depend on -t or the sink), and the time the writer spent blocked
+	* on the consumer is reported, to tell producer-bound runs from consumer-bound ones.
+*/
+
+
+#include "rnd64.h"
+
+#ifdef __linux
+	#include <errno.h>
+	#include <fcntl.h>
+	#include <sys/uio.h>
+	#include <sys/stat.h>
+#endif
+
+
+#ifdef __linux
+
+
+/* constants */
+static unsigned int const cIOV_MAX = 64;       /* chunks per writev() */
+static unsigned int const cSTREAM_SLOTS = 64;  /* stdout queue, chunks: minimum */
+
+
+/* structs */
+struct Output {
+	int iFd;
+	unsigned int iSlots;
+	Arena_t* pArena;
+	uint8_t** aBuffers;
+	size_t* aLens;
+	uint64_t* aReady;          /* chunk number + 1 when committed, 0 = free */
+	uint64_t iWritten;         /* chunks written: the next to write */
+	uint64_t iEnd;             /* chunk count, UINT64_MAX until outputFinish() */
+	uint64_t iBytes;
+	uint64_t iWrites;          /* writev() calls */
+	double fBlocked;           /* seconds in writev() */
+	double fPaused;            /* seconds producers waited for a slot, all threads */
+	int iError;
+	pthread_mutex_t rLock;
+	pthread_cond_t rReady;     /* writer: the next chunk was committed */
+	pthread_cond_t rFree;      /* producers: a slot was written */
+	pthread_t rWriter;
+};
+
+typedef struct {
+	Options_t const* pOptions;
+	rnd64_ctx_t* pCtx;
+	Output_t* pOutput;
+	uint64_t iChunks;          /* iBuffer-sized */
+	uint64_t iNext;            /* next chunk to claim */
+	int iError;
+} Stream_t;
+
+
+/**
+	* Write an I/O vector in full.
+	*
+	* @param   int iFd
+	* @param   struct iovec* aVec, advanced over partial writes
+	* @param   int iVecs
+	* @return  int, 0 on success, -1 on failure (message printed)
+*/
+
+static int writeVector(int iFd, struct iovec* aVec, int iVecs) {
+
+	while (iVecs > 0) {
+
+		ssize_t iWritten = writev(iFd, aVec, iVecs);
+
+		if (iWritten < 0 && errno == EINTR) {
+			continue;
+		}
+
+		if (iWritten <= 0) {
+			fprintf(stderr, "\n%s: write failure (%s).\n\n", pFilename, strerror(errno));
+			return -1;
+		}
+
+		while (iVecs > 0 && (size_t) iWritten >= aVec->iov_len) {
+			iWritten -= (ssize_t) aVec->iov_len;
+			aVec++;
+			iVecs--;
+		}
+
+		if (iVecs > 0) {
+			aVec->iov_base = (uint8_t*) aVec->iov_base + iWritten;
+			aVec->iov_len -= (size_t) iWritten;
+		}
+	}
+
+	return 0;
+}
+
+
+/**
+	* Thread function: write committed chunks in order.
+	*
+	* @param   void pointer st, Output_t struct
+	* @return  void* / null
+*/
+
+static void* outputWriter(void* st) {
+
+	Output_t* pOutput = (Output_t*) st;
+	struct iovec aVec[cIOV_MAX];
+
+	pthread_mutex_lock(&pOutput->rLock);
+
+	for (;;) {
+
+		while ( ! pOutput->iError && pOutput->iWritten < pOutput->iEnd && pOutput->aReady[pOutput->iWritten % pOutput->iSlots] != pOutput->iWritten + 1) {
+			pthread_cond_wait(&pOutput->rReady, &pOutput->rLock);
+		}
+
+		if (pOutput->iError || pOutput->iWritten >= pOutput->iEnd) {
+			break;
+		}
+
+		/* every consecutive ready chunk */
+		unsigned int iVecs = 0;
+		size_t iBytes = 0;
+
+		while (iVecs < cIOV_MAX && iVecs < pOutput->iSlots && pOutput->iWritten + iVecs < pOutput->iEnd) {
+
+			uint64_t iSeq = pOutput->iWritten + iVecs;
+			unsigned int iSlot = (unsigned int) (iSeq % pOutput->iSlots);
+
+			if (pOutput->aReady[iSlot] != iSeq + 1) {
+				break;
+			}
+
+			aVec[iVecs].iov_base = pOutput->aBuffers[iSlot];
+			aVec[iVecs].iov_len = pOutput->aLens[iSlot];
+			iBytes += pOutput->aLens[iSlot];
+			iVecs++;
+		}
+
+		pthread_mutex_unlock(&pOutput->rLock);
+
+		double fStart = getTime();
+		int iResult = writeVector(pOutput->iFd, aVec, (int) iVecs);
+		double fWrite = getTime() - fStart;
+
+		pthread_mutex_lock(&pOutput->rLock);
+
+		pOutput->fBlocked += fWrite;
+		pOutput->iWrites++;
+
+		if (iResult != 0) {
+			pOutput->iError = 1;
+			pthread_cond_broadcast(&pOutput->rFree);
+			break;
+		}
+
+		for (unsigned int i = 0; i < iVecs; i++) {
+			pOutput->aReady[(pOutput->iWritten + i) % pOutput->iSlots] = 0;
+		}
+
+		pOutput->iWritten += iVecs;
+		pOutput->iBytes += iBytes;
+		pthread_cond_broadcast(&pOutput->rFree);
+	}
+
+	pthread_mutex_unlock(&pOutput->rLock);
+
+	return NULL;
+}
+
+
+/**
+	* Create an ordered output stage and start its writer.
+	*
+	* @param   int iFd, destination
+	* @param   size_t iChunk, largest chunk
+	* @param   unsigned int iSlots, chunks queued at most
+	* @return  Output_t*, NULL if the buffers or the writer thread are unavailable
+*/
+
+Output_t* outputCreate(int iFd, size_t iChunk, unsigned int iSlots) {
+
+	Output_t* pOutput = (Output_t*) calloc(1, sizeof(Output_t));
+
+	if (pOutput == NULL) {
+		return NULL;
+	}
+
+	pOutput->iFd = iFd;
+	pOutput->iSlots = iSlots;
+	pOutput->iEnd = UINT64_MAX;
+	pOutput->pArena = arenaCreate(iChunk, iSlots);
+	pOutput->aBuffers = (uint8_t**) calloc(iSlots, sizeof(uint8_t*));
+	pOutput->aLens = (size_t*) calloc(iSlots, sizeof(size_t));
+	pOutput->aReady = (uint64_t*) calloc(iSlots, sizeof(uint64_t));
+
+	if (pOutput->pArena == NULL || pOutput->aBuffers == NULL || pOutput->aLens == NULL || pOutput->aReady == NULL) {
+		arenaDestroy(pOutput->pArena);
+		free(pOutput->aBuffers);
+		free(pOutput->aLens);
+		free(pOutput->aReady);
+		free(pOutput);
+		return NULL;
+	}
+
+	for (unsigned int i = 0; i < iSlots; i++) {
+		pOutput->aBuffers[i] = (uint8_t*) arenaAcquire(pOutput->pArena);
+	}
+
+	pthread_mutex_init(&pOutput->rLock, NULL);
+	pthread_cond_init(&pOutput->rReady, NULL);
+	pthread_cond_init(&pOutput->rFree, NULL);
+
+	if (pthread_create(&pOutput->rWriter, NULL, outputWriter, pOutput) != 0) {
+		pthread_cond_destroy(&pOutput->rFree);
+		pthread_cond_destroy(&pOutput->rReady);
+		pthread_mutex_destroy(&pOutput->rLock);
+		arenaDestroy(pOutput->pArena);
+		free(pOutput->aBuffers);
+		free(pOutput->aLens);
+		free(pOutput->aReady);
+		free(pOutput);
+		return NULL;
+	}
+
+	return pOutput;
+}
+
+
+/**
+	* Buffer for chunk iSeq, waiting while the queue is full.
+	*
+	* @param   Output_t* pOutput
+	* @param   uint64_t iSeq, chunk number
+	* @return  uint8_t*, NULL after a write failure: stop producing
+*/
+
+uint8_t* outputAcquire(Output_t* pOutput, uint64_t iSeq) {
+
+	pthread_mutex_lock(&pOutput->rLock);
+
+	if ( ! pOutput->iError && iSeq >= pOutput->iWritten + pOutput->iSlots) {
+
+		/* backpressure: generation pauses until the writer frees this slot */
+		double fStart = getTime();
+
+		while ( ! pOutput->iError && iSeq >= pOutput->iWritten + pOutput->iSlots) {
+			pthread_cond_wait(&pOutput->rFree, &pOutput->rLock);
+		}
+
+		pOutput->fPaused += getTime() - fStart;
+	}
+
+	int iError = pOutput->iError;
+
+	pthread_mutex_unlock(&pOutput->rLock);
+
+	return iError ? NULL : pOutput->aBuffers[iSeq % pOutput->iSlots];
+}
+
+
+/**
+	* Queue filled chunk iSeq for writing.
+	*
+	* @param   Output_t* pOutput
+	* @param   uint64_t iSeq
+	* @param   size_t iLen, bytes filled
+	* @return  void
+*/
+
+void outputCommit(Output_t* pOutput, uint64_t iSeq, size_t iLen) {
+
+	unsigned int iSlot = (unsigned int) (iSeq % pOutput->iSlots);
+
+	pthread_mutex_lock(&pOutput->rLock);
+
+	pOutput->aLens[iSlot] = iLen;
+	pOutput->aReady[iSlot] = iSeq + 1;
+
+	if (iSeq == pOutput->iWritten) {
+		pthread_cond_signal(&pOutput->rReady);
+	}
+
+	pthread_mutex_unlock(&pOutput->rLock);
+}
+
+
+/**
+	* Stop after a producer failure: wake waiting producers (outputAcquire() returns NULL) and the writer.
+	*
+	* @param   Output_t* pOutput
+	* @return  void
+*/
+
+void outputAbort(Output_t* pOutput) {
+
+	pthread_mutex_lock(&pOutput->rLock);
+	pOutput->iError = 1;
+	pthread_cond_broadcast(&pOutput->rFree);
+	pthread_cond_signal(&pOutput->rReady);
+	pthread_mutex_unlock(&pOutput->rLock);
+}
+
+
+/**
+	* Write out the first iCount chunks, stop the writer and release the stage.
+	*
+	* @param   Output_t* pOutput
+	* @param   uint64_t iCount, chunks produced
+	* @param   OutputStats_t* pStats, populated, or NULL
+	* @return  int, 0 on success, -1 on a write failure (message printed) or after outputAbort()
+*/
+
+int outputFinish(Output_t* pOutput, uint64_t iCount, OutputStats_t* pStats) {
+
+	pthread_mutex_lock(&pOutput->rLock);
+	pOutput->iEnd = iCount;
+	pthread_cond_signal(&pOutput->rReady);
+	pthread_mutex_unlock(&pOutput->rLock);
+
+	pthread_join(pOutput->rWriter, NULL);
+
+	int iResult = pOutput->iError ? -1 : 0;
+
+	if (pStats != NULL) {
+		pStats->iBytes = pOutput->iBytes;
+		pStats->iWrites = pOutput->iWrites;
+		pStats->fBlocked = pOutput->fBlocked;
+		pStats->fPaused = pOutput->fPaused;
+	}
+
+	pthread_cond_destroy(&pOutput->rFree);
+	pthread_cond_destroy(&pOutput->rReady);
+	pthread_mutex_destroy(&pOutput->rLock);
+	arenaDestroy(pOutput->pArena);
+	free(pOutput->aBuffers);
+	free(pOutput->aLens);
+	free(pOutput->aReady);
+	free(pOutput);
+
+	return iResult;
+}
+
+
+/**
+	* Thread function: claim stream chunks, generate them at their stream offset and queue them.
+	*
+	* @param   void pointer st, Stream_t struct
+	* @return  void* / null
+*/
+
+static void* streamWorker(void* st) {
+
+	Stream_t* pStream = (Stream_t*) st;
+	unsigned int iBuffer = pStream->pOptions->iBuffer;
+	uint64_t iBytes = pStream->pOptions->iBytes;
+	uint64_t iPositioned = UINT64_MAX; /* chunk the context is at */
+	rnd64_ctx_t* pCtx = rnd64_clone(pStream->pCtx);
+
+	if (pCtx == NULL) {
+		fprintf(stderr, "\n%s: generator initialisation failed.\n\n", pFilename);
+		__atomic_store_n(&pStream->iError, 1, __ATOMIC_RELAXED);
+		outputAbort(pStream->pOutput);
+	}
+
+	while (pCtx != NULL) {
+
+		uint64_t iChunk = __atomic_fetch_add(&pStream->iNext, 1, __ATOMIC_RELAXED);
+
+		if (iChunk >= pStream->iChunks) {
+			break;
+		}
+
+		size_t iLen = (iBytes - iChunk * iBuffer < iBuffer) ? (size_t) (iBytes - iChunk * iBuffer) : iBuffer;
+		uint8_t* pBuffer = outputAcquire(pStream->pOutput, iChunk);
+
+		if (pBuffer == NULL) {
+			break;
+		}
+
+		if (iChunk != iPositioned) {
+			rnd64_seek(pCtx, iChunk * iBuffer);
+		}
+
+		if (rnd64_fill(pCtx, pBuffer, iLen) != 0) {
+			fprintf(stderr, "\n%s: insufficient crypto random bytes available.\n\n", pFilename);
+			__atomic_store_n(&pStream->iError, 1, __ATOMIC_RELAXED);
+			outputAbort(pStream->pOutput);
+			break;
+		}
+
+		outputCommit(pStream->pOutput, iChunk, iLen);
+		iPositioned = iChunk + 1;
+	}
+
+	rnd64_destroy(pCtx);
+
+	return NULL;
+}
+
+
+/**
+	* Generate <size> bytes from -t threads into a descriptor through the ordered output stage.
+	*
+	* @param   Options_t* pOptions, size, buffer, threads and generator
+	* @param   int iFd
+	* @param   OutputStats_t* pStats, filled in
+	* @param   double* pTime, seconds from the first chunk to the last write
+	* @return  int, 0 on success, -1 on failure (message printed)
+*/
+
+int streamRun(Options_t const* pOptions, int iFd, OutputStats_t* pStats, double* pTime) {
+
+	unsigned int iNumThreads = pOptions->iThreads;
+	unsigned int iSlots = (4 * iNumThreads > cSTREAM_SLOTS) ? 4 * iNumThreads : cSTREAM_SLOTS;
+	unsigned int iStarted = 0;
+	Stream_t stream;
+
+	memset(&stream, 0, sizeof(stream));
+	memset(pStats, 0, sizeof(OutputStats_t));
+	*pTime = 0;
+
+	stream.pOptions = pOptions;
+	stream.iChunks = (pOptions->iBytes + pOptions->iBuffer - 1) / pOptions->iBuffer;
+
+	if (iNumThreads > stream.iChunks) {
+		iNumThreads = (unsigned int) stream.iChunks;
+	}
+
+	stream.pCtx = rnd64_create(pOptions->iMode, pOptions->iEngine, pOptions->iSeed);
+
+	if (stream.pCtx == NULL) {
+		fprintf(stderr, "\n%s: secure data generation unavailable.\n\n", pFilename);
+		return -1;
+	}
+
+	stream.pOutput = outputCreate(iFd, pOptions->iBuffer, iSlots);
+
+	if (stream.pOutput == NULL) {
+		fprintf(stderr, "\n%s: insufficient memory for %u buffers of %u bytes.\n\n", pFilename, iSlots, pOptions->iBuffer);
+		rnd64_destroy(stream.pCtx);
+		return -1;
+	}
+
+	pthread_t rThreadID[iNumThreads];
+	double fStart = getTime();
+
+	for (unsigned int i = 0; i < iNumThreads; i++) {
+
+		if (pthread_create(&rThreadID[i], NULL, streamWorker, &stream) != 0) {
+			fprintf(stderr, "\n%s: generator thread cannot be started.\n\n", pFilename);
+			__atomic_store_n(&stream.iError, 1, __ATOMIC_RELAXED);
+			outputAbort(stream.pOutput);
+			break;
+		}
+
+		iStarted++;
+	}
+
+	for (unsigned int i = 0; i < iStarted; i++) {
+		pthread_join(rThreadID[i], NULL);
+	}
+
+	if (outputFinish(stream.pOutput, stream.iError ? 0 : stream.iChunks, pStats) != 0) {
+		stream.iError = 1;
+	}
+
+	*pTime = getTime() - fStart;
+
+	rnd64_destroy(stream.pCtx);
+
+	return stream.iError ? -1 : 0;
+}
+
+
+/**
+	* Stream <size> bytes to stdout, or to [file], through the ordered output stage.
+	*
+	* @param   Options_t* pOptions
+	* @return  int, EXIT_SUCCESS / EXIT_FAILURE
+*/
+
+int streamOut(Options_t const* pOptions) {
+
+	unsigned int iPipe = 0;
+	int iFd = STDOUT_FILENO;
+	int iResult = 0;
+	double fTime = 0;
+	char const* sSink = "file";
+	struct stat rStat;
+	OutputStats_t stats;
+
+	if (pOptions->sOutput != NULL) {
+
+		iFd = open(pOptions->sOutput, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+		if (iFd < 0) {
+			fprintf(stderr, "\n%s: output file cannot be written.\n(check write permissions / filename characters)\n\n", pFilename);
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (fstat(iFd, &rStat) == 0) {
+
+		if (S_ISFIFO(rStat.st_mode)) {
+
+			/* the host profile's tuned size, else as large as allowed: halve on EPERM (user pipe page limit) */
+			unsigned int iTarget = (pOptions->iPipeSize > 0) ? pOptions->iPipeSize : pipeMaxSize();
+
+			iPipe = setPipeSize(iFd, iTarget);
+
+			while (iPipe < iTarget && iTarget > 64 * KB) {
+				iTarget /= 2;
+				iPipe = setPipeSize(iFd, iTarget);
+			}
+
+			sSink = "pipe";
+		}
+		else if (S_ISSOCK(rStat.st_mode)) {
+			sSink = "socket"; /* send buffer left to kernel autotuning */
+		}
+		else if (S_ISCHR(rStat.st_mode)) {
+			sSink = "device";
+		}
+	}
+
+	iResult = streamRun(pOptions, iFd, &stats, &fTime);
+
+	if (iFd != STDOUT_FILENO && close(iFd) != 0) {
+		fprintf(stderr, "\n%s: output file write failure (%s).\n\n", pFilename, strerror(errno));
+		iResult = -1;
+	}
+
+	if (pOptions->sOutput != NULL && iResult == 0) {
+
+		printf("\n%s generated\n\nsize: %"PRIu64" bytes\n", pOptions->sOutput, stats.iBytes);
+		printf("time: %d s %d ms\n", (int) fTime, (int) (fTime * 1000) % 1000);
+
+		/* MB/s calculation for size over 50MB */
+		if (stats.iBytes > 52428800 && fTime > 0) {
+			printf("MB/s: %0.2f\n", (stats.iBytes * cMBRECIP * cMBRECIP) / fTime);
+		}
+
+		printf("\n");
+	}
+	else if (pOptions->sOutput == NULL && isatty(STDERR_FILENO) && fTime > 0) { /* interactive runs only: a pipeline's stderr stays clean */
+
+		uint64_t iChunks = (pOptions->iBytes + pOptions->iBuffer - 1) / pOptions->iBuffer;
+		unsigned int iNumThreads = (pOptions->iThreads > iChunks) ? (unsigned int) iChunks : pOptions->iThreads;
+		double fBlocked = 100 * stats.fBlocked / fTime;
+		double fPaused = 100 * stats.fPaused / (fTime * iNumThreads);
+
+		fprintf(stderr, "\nstream: %"PRIu64" bytes to %s", stats.iBytes, sSink);
+
+		if (iPipe > 0) {
+			fprintf(stderr, " (%u bytes)", iPipe);
+		}
+
+		fprintf(stderr, "  time: %d s %d ms  MB/s: %0.2f\n", (int) fTime, (int) (fTime * 1000) % 1000, (stats.iBytes * cMBRECIP * cMBRECIP) / fTime);
+		fprintf(stderr, "blocked on consumer: %0.1f%%  generation paused: %0.1f%%  writes: %"PRIu64" (%"PRIu64" bytes avg): %s-bound\n\n", fBlocked, fPaused, stats.iWrites, (stats.iWrites > 0) ? stats.iBytes / stats.iWrites : 0, (fBlocked > 50) ? "consumer" : "producer");
+	}
+
+	return (iResult != 0) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+
+#elif _WIN64
+
+
+/* Linux only: the Windows stream path writes from each thread (generateStream()) */
+
+Output_t* outputCreate(int iFd, size_t iChunk, unsigned int iSlots) {
+
+	(void) iFd;
+	(void) iChunk;
+	(void) iSlots;
+
+	return NULL;
+}
+
+uint8_t* outputAcquire(Output_t* pOutput, uint64_t iSeq) {
+
+	(void) pOutput;
+	(void) iSeq;
+
+	return NULL;
+}
+
+void outputCommit(Output_t* pOutput, uint64_t iSeq, size_t iLen) {
+
+	(void) pOutput;
+	(void) iSeq;
+	(void) iLen;
+}
+
+void outputAbort(Output_t* pOutput) {
+
+	(void) pOutput;
+}
+
+int outputFinish(Output_t* pOutput, uint64_t iCount, OutputStats_t* pStats) {
+
+	(void) pOutput;
+	(void) iCount;
+	(void) pStats;
+
+	return -1;
+}
+
+int streamRun(Options_t const* pOptions, int iFd, OutputStats_t* pStats, double* pTime) {
+
+	(void) pOptions;
+	(void) iFd;
+	(void) pStats;
+	(void) pTime;
+
+	return -1;
+}
+
+int streamOut(Options_t const* pOptions) {
+
+	(void) pOptions;
+
+	return EXIT_FAILURE;
+}
+
+
+#endif
@@ -0,0 +1,591 @@
+/**
+	* RND64
+	* rnd64_overwrite.c
+	*
+	* In-place overwrite: --overwrite PATH rewrites an existing file or block device, without truncating it,
+	* in one or more passes of random data, a constant byte, or a verify read-back.
+	*
+	* @author        Martin Latter
+	* @copyright     Martin Latter, April 2014
+	* @version       0.42 mt
+	* @license       GNU GPL version 3.0 (GPL v3); https://www.gnu.org/licenses/gpl-3.0.html
+	* @link          https://github.com/Tinram/RND64.git
+	*
+	* The target is split into --qd disjoint regions, one writer thread each, so --qd writes are in flight at
+	* once. Writes use O_DIRECT where the target accepts it (a sub-4 kB tail goes through the page cache), and
+	* each pass ends with fdatasync(). Random passes use the seekable PCG stream of the pass, so a verify pass
+	* regenerates the expected data rather than storing it. Device size comes from BLKGETSIZE64.
+	*
+	* Example:       rnd64 --overwrite /dev/sdX --passes random,zero,verify --discard
+*/
+
+
+#define _GNU_SOURCE /* O_DIRECT, fallocate() */
+
+#include "rnd64.h"
+
+#ifdef __linux
+	#include <fcntl.h>
+	#include <errno.h>
+	#include <sys/stat.h>
+	#include <sys/ioctl.h>
+	#include <linux/fs.h>
+	#include <linux/falloc.h>
+#endif
+
+
+#ifdef __linux
+
+
+/* defines */
+#define PASSES_MAX 16
+
+
+/* constants */
+static size_t const cCHUNK = 1024 * KB;      /* I/O size */
+static uint64_t const cDIRECT_ALIGN = 4 * KB; /* O_DIRECT offset and length alignment */
+static unsigned int const cQUEUE_DEPTH = 32; /* default --qd */
+
+
+/* enums */
+typedef enum {
+	PASS_RANDOM = 0,
+	PASS_CONSTANT,
+	PASS_VERIFY
+} PassType_t;
+
+
+/* structs */
+typedef struct {
+	PassType_t iType;
+	uint8_t iByte;             /* PASS_CONSTANT */
+	char sName[16];
+} Pass_t;
+
+typedef struct {
+	int iFd;                   /* O_DIRECT where supported */
+	int iTailFd;               /* buffered, for the unaligned tail */
+	uint64_t iSize;
+	uint64_t iAligned;         /* iSize rounded down to cDIRECT_ALIGN */
+	rnd64_ctx_t* pCtx;
+	Arena_t* pArena;
+	Pass_t const* pPass;
+	Pass_t const* pExpected;   /* verify: the last write pass */
+	unsigned int iStream;      /* PCG stream of the random pass being written or verified */
+} Overwrite_t;
+
+typedef struct {
+	Overwrite_t const* pShared;
+	uint64_t iOffset;
+	uint64_t iLen;
+	uint64_t iMismatched;      /* verify: bytes differing */
+	uint64_t iFirstBad;        /* verify: offset of the first */
+	int iError;
+} OverwriteWorker_t;
+
+
+/**
+	* Read or write a whole range, retrying short transfers.
+	*
+	* @param   int iFd
+	* @param   int iWrite, 1 = pwrite(), 0 = pread()
+	* @param   uint8_t* pBuffer
+	* @param   size_t iLen
+	* @param   uint64_t iOffset
+	* @return  int, 0 on success, -1 on failure (message printed)
+*/
+
+static int transfer(int iFd, int iWrite, uint8_t* pBuffer, size_t iLen, uint64_t iOffset) {
+
+	size_t iDone = 0;
+
+	while (iDone < iLen) {
+
+		ssize_t iResult = iWrite ? pwrite(iFd, pBuffer + iDone, iLen - iDone, (off_t) (iOffset + iDone)) : pread(iFd, pBuffer + iDone, iLen - iDone, (off_t) (iOffset + iDone));
+
+		if (iResult < 0 && errno == EINTR) {
+			continue;
+		}
+
+		if (iResult <= 0) {
+			fprintf(stderr, "\n%s: %s failure at offset %"PRIu64" (%s).\n\n", pFilename, iWrite ? "write" : "read", iOffset + iDone, (iResult < 0) ? strerror(errno) : "end of device");
+			return -1;
+		}
+
+		iDone += (size_t) iResult;
+	}
+
+	return 0;
+}
+
+
+/**
+	* Transfer a range: the aligned part through the O_DIRECT descriptor, any tail through the buffered one.
+	*
+	* @param   Overwrite_t* pShared
+	* @param   int iWrite
+	* @param   uint8_t* pBuffer
+	* @param   size_t iLen
+	* @param   uint64_t iOffset
+	* @return  int, 0 on success, -1 on failure
+*/
+
+static int transferRange(Overwrite_t const* pShared, int iWrite, uint8_t* pBuffer, size_t iLen, uint64_t iOffset) {
+
+	size_t iDirect = 0;
+
+	if (iOffset < pShared->iAligned) {
+		iDirect = (iOffset + iLen <= pShared->iAligned) ? iLen : (size_t) (pShared->iAligned - iOffset);
+	}
+
+	if (iDirect > 0 && transfer(pShared->iFd, iWrite, pBuffer, iDirect, iOffset) != 0) {
+		return -1;
+	}
+
+	if (iLen > iDirect && transfer(pShared->iTailFd, iWrite, pBuffer + iDirect, iLen - iDirect, iOffset + iDirect) != 0) {
+		return -1;
+	}
+
+	return 0;
+}
+
+
+/**
+	* Generate the random pass content of a range.
+	*
+	* @param   rnd64_ctx_t* pCtx, on the pass stream at the range start
+	* @param   uint8_t* pBuffer
+	* @param   size_t iLen
+	* @return  int, 0 on success, -1 on failure (message printed)
+*/
+
+static int randomData(rnd64_ctx_t* pCtx, uint8_t* pBuffer, size_t iLen) {
+
+	/* fill in cache-sized pieces */
+	for (size_t i = 0; i < iLen; i += cBUFFER) {
+
+		if (rnd64_fill(pCtx, pBuffer + i, (iLen - i < cBUFFER) ? iLen - i : cBUFFER) != 0) {
+			fprintf(stderr, "\n%s: insufficient crypto random bytes available.\n\n", pFilename);
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+
+/**
+	* Thread function: run the current pass over one region.
+	*
+	* @param   void pointer st, OverwriteWorker_t struct
+	* @return  void* / null
+*/
+
+static void* overwriteWorker(void* st) {
+
+	OverwriteWorker_t* pWorker = (OverwriteWorker_t*) st;
+	Overwrite_t const* pShared = pWorker->pShared;
+	Pass_t const* pData = (pShared->pPass->iType == PASS_VERIFY) ? pShared->pExpected : pShared->pPass;
+	uint8_t* pBuffer = (uint8_t*) arenaAcquire(pShared->pArena);
+	uint8_t* pRead = (uint8_t*) arenaAcquire(pShared->pArena);
+	rnd64_ctx_t* pCtx = NULL;
+
+	if (pData->iType == PASS_RANDOM) {
+
+		pCtx = rnd64_clone(pShared->pCtx);
+
+		if (pCtx == NULL) {
+			fprintf(stderr, "\n%s: generator initialisation failed.\n\n", pFilename);
+			pWorker->iError = 1;
+			goto exit;
+		}
+
+		rnd64_stream(pCtx, pShared->iStream);
+		rnd64_seek(pCtx, pWorker->iOffset);
+	}
+	else {
+		memset(pBuffer, pData->iByte, cCHUNK);
+	}
+
+	for (uint64_t iPos = pWorker->iOffset; iPos < pWorker->iOffset + pWorker->iLen; iPos += cCHUNK) {
+
+		size_t iLen = (pWorker->iOffset + pWorker->iLen - iPos < cCHUNK) ? (size_t) (pWorker->iOffset + pWorker->iLen - iPos) : cCHUNK;
+
+		if (pData->iType == PASS_RANDOM && randomData(pCtx, pBuffer, iLen) != 0) {
+			pWorker->iError = 1;
+			break;
+		}
+
+		if (pShared->pPass->iType != PASS_VERIFY) {
+
+			if (transferRange(pShared, 1, pBuffer, iLen, iPos) != 0) {
+				pWorker->iError = 1;
+				break;
+			}
+
+			continue;
+		}
+
+		if (transferRange(pShared, 0, pRead, iLen, iPos) != 0) {
+			pWorker->iError = 1;
+			break;
+		}
+
+		if (memcmp(pRead, pBuffer, iLen) != 0) {
+
+			for (size_t i = 0; i < iLen; i++) {
+
+				if (pRead[i] != pBuffer[i]) {
+
+					if (pWorker->iMismatched++ == 0) {
+						pWorker->iFirstBad = iPos + i;
+					}
+				}
+			}
+		}
+	}
+
+	exit:
+
+	rnd64_destroy(pCtx);
+	arenaRelease(pShared->pArena, pRead);
+	arenaRelease(pShared->pArena, pBuffer);
+
+	return NULL;
+}
+
+
+/**
+	* Parse a --passes list, e.g. random,zero,verify.
+	*
+	* @param   char* sPasses
+	* @param   Pass_t* aPasses, PASSES_MAX
+	* @param   rnd64_engine_t iEngine, random passes' engine: crypto output cannot be verified
+	* @return  unsigned int, passes, 0 on error (message printed)
+*/
+
+static unsigned int parsePasses(char const* sPasses, Pass_t* aPasses, rnd64_engine_t iEngine) {
+
+	unsigned int iPasses = 0;
+	int iLastWrite = -1;
+	char const* pStart = sPasses;
+
+	for (;;) {
+
+		char const* pEnd = strchr(pStart, ',');
+		size_t iLen = (pEnd != NULL) ? (size_t) (pEnd - pStart) : strlen(pStart);
+		char sName[16];
+		Pass_t* pPass = &aPasses[iPasses];
+
+		if (iPasses == PASSES_MAX || iLen == 0 || iLen >= sizeof(sName)) {
+			fprintf(stderr, "\n%s: --passes takes up to %u of random, zero, one, 0xNN, verify; comma-separated\n\n", pFilename, PASSES_MAX);
+			return 0;
+		}
+
+		memcpy(sName, pStart, iLen);
+		sName[iLen] = '\0';
+
+		if (strcmp(sName, "random") == 0) {
+			pPass->iType = PASS_RANDOM;
+		}
+		else if (strcmp(sName, "zero") == 0 || strcmp(sName, "one") == 0) {
+			pPass->iType = PASS_CONSTANT;
+			pPass->iByte = (sName[0] == 'z') ? 0x00 : 0xFF;
+		}
+		else if (strncmp(sName, "0x", 2) == 0 && iLen == 4 && isxdigit((unsigned char) sName[2]) && isxdigit((unsigned char) sName[3])) {
+			pPass->iType = PASS_CONSTANT;
+			pPass->iByte = (uint8_t) strtoul(sName, NULL, 16);
+		}
+		else if (strcmp(sName, "verify") == 0) {
+
+			if (iLastWrite < 0) {
+				fprintf(stderr, "\n%s: --passes: verify must follow a write pass\n\n", pFilename);
+				return 0;
+			}
+
+			if (aPasses[iLastWrite].iType == PASS_RANDOM && iEngine == RND64_ENGINE_CRYPTO) {
+				fprintf(stderr, "\n%s: --passes: crypto (-c) output cannot be regenerated to verify; use PCG (-a) random passes\n\n", pFilename);
+				return 0;
+			}
+
+			pPass->iType = PASS_VERIFY;
+		}
+		else {
+			fprintf(stderr, "\n%s: --passes: unknown pass '%s' (random, zero, one, 0xNN, verify)\n\n", pFilename, sName);
+			return 0;
+		}
+
+		snprintf(pPass->sName, sizeof(pPass->sName), "%s", sName);
+
+		if (pPass->iType != PASS_VERIFY) {
+			iLastWrite = (int) iPasses;
+		}
+
+		iPasses++;
+
+		if (pEnd == NULL) {
+			break;
+		}
+
+		pStart = pEnd + 1;
+	}
+
+	return iPasses;
+}
+
+
+/**
+	* Discard the target's blocks: BLKDISCARD on devices, hole punching on files.
+	*
+	* @param   int iFd
+	* @param   int iDevice
+	* @param   uint64_t iSize
+	* @return  void
+*/
+
+static void discard(int iFd, int iDevice, uint64_t iSize) {
+
+	int iResult = 0;
+
+	if (iDevice) {
+		uint64_t aRange[2] = {0, iSize};
+		iResult = ioctl(iFd, BLKDISCARD, aRange);
+	}
+	else {
+		iResult = fallocate(iFd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, 0, (off_t) iSize);
+	}
+
+	if (iResult == 0) {
+		printf("discard: done\n");
+	}
+	else {
+		printf("discard: not supported (%s), continuing\n", strerror(errno));
+	}
+}
+
+
+/**
+	* Overwrite an existing file or block device in place, in passes.
+	*
+	* @param   Options_t* pOptions
+	* @return  int, EXIT_SUCCESS / EXIT_FAILURE
+*/
+
+int overwrite(Options_t const* pOptions) {
+
+	Pass_t aPasses[PASSES_MAX];
+	unsigned int iPasses = parsePasses((pOptions->sPasses != NULL) ? pOptions->sPasses : "random", aPasses, pOptions->iEngine);
+	unsigned int iWriters = (pOptions->iQueueDepth > 0) ? pOptions->iQueueDepth : cQUEUE_DEPTH;
+	int iDevice = 0;
+	int iDirect = 1;
+	int iResult = EXIT_SUCCESS;
+	struct stat rStat;
+	Overwrite_t shared;
+
+	if (iPasses == 0) {
+		return EXIT_FAILURE;
+	}
+
+	memset(&shared, 0, sizeof(shared));
+
+	if (stat(pOptions->sOverwrite, &rStat) != 0) {
+		fprintf(stderr, "\n%s: '%s' cannot be opened (%s).\n\n", pFilename, pOptions->sOverwrite, strerror(errno));
+		return EXIT_FAILURE;
+	}
+
+	if ( ! S_ISREG(rStat.st_mode) && ! S_ISBLK(rStat.st_mode)) {
+		fprintf(stderr, "\n%s: '%s' is not a regular file or block device.\n\n", pFilename, pOptions->sOverwrite);
+		return EXIT_FAILURE;
+	}
+
+	iDevice = S_ISBLK(rStat.st_mode);
+
+	shared.iFd = open(pOptions->sOverwrite, O_RDWR | O_DIRECT);
+
+	if (shared.iFd < 0 && errno == EINVAL) { /* filesystem without O_DIRECT, e.g. tmpfs */
+		shared.iFd = open(pOptions->sOverwrite, O_RDWR);
+		iDirect = 0;
+	}
+
+	shared.iTailFd = open(pOptions->sOverwrite, O_RDWR);
+
+	if (shared.iFd < 0 || shared.iTailFd < 0) {
+		fprintf(stderr, "\n%s: '%s' cannot be opened for writing (%s).\n\n", pFilename, pOptions->sOverwrite, strerror(errno));
+
+		if (shared.iFd >= 0) {
+			close(shared.iFd);
+		}
+
+		return EXIT_FAILURE;
+	}
+
+	if (iDevice) {
+
+		if (ioctl(shared.iFd, BLKGETSIZE64, &shared.iSize) != 0) {
+			fprintf(stderr, "\n%s: '%s': device size unavailable (%s).\n\n", pFilename, pOptions->sOverwrite, strerror(errno));
+			close(shared.iTailFd);
+			close(shared.iFd);
+			return EXIT_FAILURE;
+		}
+	}
+	else {
+		shared.iSize = (uint64_t) rStat.st_size;
+	}
+
+	if (shared.iSize == 0) {
+		fprintf(stderr, "\n%s: '%s' is empty: nothing to overwrite.\n\n", pFilename, pOptions->sOverwrite);
+		close(shared.iTailFd);
+		close(shared.iFd);
+		return EXIT_FAILURE;
+	}
+
+	shared.iAligned = iDirect ? shared.iSize & ~(cDIRECT_ALIGN - 1) : 0;
+
+	/* disjoint regions of whole chunks, the remainder to the last */
+	uint64_t iChunks = (shared.iSize + cCHUNK - 1) / cCHUNK;
+
+	if (iWriters > iChunks) {
+		iWriters = (unsigned int) iChunks;
+	}
+
+	uint64_t iRegion = (iChunks / iWriters) * cCHUNK;
+	pthread_t* aThreadID = (pthread_t*) calloc(iWriters, sizeof(pthread_t));
+	OverwriteWorker_t* aWorkers = (OverwriteWorker_t*) calloc(iWriters, sizeof(OverwriteWorker_t));
+
+	shared.pCtx = rnd64_create(RND64_MODE_ALL, pOptions->iEngine, pOptions->iSeed);
+	shared.pArena = arenaCreate(cCHUNK, 2 * iWriters);
+
+	if (shared.pCtx == NULL || shared.pArena == NULL || aThreadID == NULL || aWorkers == NULL) {
+		fprintf(stderr, "\n%s: %s.\n\n", pFilename, (shared.pCtx == NULL) ? "secure data generation unavailable" : "insufficient memory for I/O buffers");
+		rnd64_destroy(shared.pCtx);
+		arenaDestroy(shared.pArena);
+		free(aWorkers);
+		free(aThreadID);
+		close(shared.iTailFd);
+		close(shared.iFd);
+		return EXIT_FAILURE;
+	}
+
+	printf("\noverwrite: %s  %"PRIu64" bytes (%s)  %s  writers: %u\n", pOptions->sOverwrite, shared.iSize, iDevice ? "block device" : "file", iDirect ? "O_DIRECT" : "buffered", iWriters);
+
+	if (pOptions->iEngine == RND64_ENGINE_PCG32) {
+		printf("seed: 0x%016"PRIx64"\n", rnd64_seed(shared.pCtx));
+	}
+
+	if (pOptions->iDiscard) {
+		discard(shared.iTailFd, iDevice, shared.iSize);
+	}
+
+	printf("\n");
+
+	for (unsigned int p = 0; p < iPasses && iResult == EXIT_SUCCESS; p++) {
+
+		uint64_t iMismatched = 0;
+		uint64_t iFirstBad = UINT64_MAX;
+		double fStart = getTime();
+
+		unsigned int iStarted = 0;
+
+		shared.pPass = &aPasses[p];
+
+		if (aPasses[p].iType != PASS_VERIFY) {
+			shared.pExpected = &aPasses[p];
+			shared.iStream = p;
+		}
+
+		for (unsigned int i = 0; i < iWriters; i++) {
+
+			memset(&aWorkers[i], 0, sizeof(OverwriteWorker_t));
+			aWorkers[i].pShared = &shared;
+			aWorkers[i].iOffset = i * iRegion;
+			aWorkers[i].iLen = (i == iWriters - 1) ? shared.iSize - i * iRegion : iRegion;
+
+			/* every region has one writer: a missing thread fails the pass */
+			if (pthread_create(&aThreadID[i], NULL, overwriteWorker, &aWorkers[i]) != 0) {
+				fprintf(stderr, "\n%s: writer thread cannot be started.\n\n", pFilename);
+				iResult = EXIT_FAILURE;
+				break;
+			}
+
+			iStarted++;
+		}
+
+		for (unsigned int i = 0; i < iStarted; i++) {
+
+			pthread_join(aThreadID[i], NULL);
+
+			if (aWorkers[i].iError) {
+				iResult = EXIT_FAILURE;
+			}
+
+			if (aWorkers[i].iMismatched > 0 && aWorkers[i].iFirstBad < iFirstBad) {
+				iFirstBad = aWorkers[i].iFirstBad;
+			}
+
+			iMismatched += aWorkers[i].iMismatched;
+		}
+
+		if (aPasses[p].iType != PASS_VERIFY) {
+
+			if (fdatasync(shared.iFd) != 0 || fdatasync(shared.iTailFd) != 0) {
+				fprintf(stderr, "\n%s: sync failure (%s).\n\n", pFilename, strerror(errno));
+				iResult = EXIT_FAILURE;
+			}
+
+			/* so a verify pass reads the media, not cached pages of the tail or a buffered target */
+			posix_fadvise(shared.iTailFd, 0, 0, POSIX_FADV_DONTNEED);
+		}
+
+		double fTime = getTime() - fStart;
+
+		printf("pass %u/%u  %-7s %d s %d ms", p + 1, iPasses, aPasses[p].sName, (int) fTime, (int) (fTime * 1000) % 1000);
+
+		if (fTime > 0) {
+			printf("  %0.2f MB/s", (shared.iSize * cMBRECIP * cMBRECIP) / fTime);
+		}
+
+		if (aPasses[p].iType == PASS_VERIFY) {
+			printf("  mismatched bytes: %"PRIu64, iMismatched);
+		}
+
+		printf("\n");
+
+		if (iMismatched > 0) {
+			fprintf(stderr, "\n%s: verify failed: %"PRIu64" bytes differ, first at offset %"PRIu64".\n\n", pFilename, iMismatched, iFirstBad);
+			iResult = EXIT_FAILURE;
+		}
+	}
+
+	printf("\n");
+
+	rnd64_destroy(shared.pCtx);
+	arenaDestroy(shared.pArena);
+	free(aWorkers);
+	free(aThreadID);
+	close(shared.iTailFd);
+	close(shared.iFd);
+
+	return iResult;
+}
+
+
+#elif _WIN64
+
+
+/**
+	* Overwrite a file or device in place (Linux only: O_DIRECT, BLKGETSIZE64).
+	*
+	* @param   Options_t* pOptions
+	* @return  int, EXIT_FAILURE
+*/
+
+int overwrite(Options_t const* pOptions) {
+
+	(void) pOptions;
+	fprintf(stderr, "\n%s: --overwrite is not available on this platform.\n\n", pFilename);
+
+	return EXIT_FAILURE;
+}
+
+
+#endif
@@ -0,0 +1,445 @@
+/**
+	* RND64
+	* rnd64_randwrite.c
+	*
+	* Random-order file output: --order random writes [file] block by block in a seeded shuffled order, from
+	* --qd concurrent writers, and reports IOPS and write latency percentiles.
+	*
+	* @author        Martin Latter
+	* @copyright     Martin Latter, April 2014
+	* @version       0.42 mt
+	* @license       GNU GPL version 3.0 (GPL v3); https://www.gnu.org/licenses/gpl-3.0.html
+	* @link          https://github.com/Tinram/RND64.git
+	*
+	* The order is a keyed Feistel permutation of the block numbers (cycle-walked into range), so every block is
+	* written exactly once with no per-block state, at any file size. Block content is the stream at the block's
+	* offset, so the finished file equals sequential output with the same seed, file or stdout at any -t: only the
+	* write order differs.
+	* Writes use O_DIRECT when the block size allows it; latencies are kept in log-linear histograms.
+	*
+	* Example:       rnd64 -a 16g f.bin --order random --block 4k --qd 32 -s 1
+*/
+
+
+#define _GNU_SOURCE /* O_DIRECT */
+
+#include "rnd64.h"
+
+#ifdef __linux
+	#include <fcntl.h>
+	#include <errno.h>
+#endif
+
+
+/* seeded permutation, shared with --mutate */
+
+
+/**
+	* 64-bit mixer (splitmix64 finaliser).
+	*
+	* @param   uint64_t iX
+	* @return  uint64_t
+*/
+
+uint64_t mix64(uint64_t iX) {
+
+	iX ^= iX >> 30;
+	iX *= 0xBF58476D1CE4E5B9ULL;
+	iX ^= iX >> 27;
+	iX *= 0x94D049BB133111EBULL;
+	iX ^= iX >> 31;
+
+	return iX;
+}
+
+
+/**
+	* Map a permutation index in [0, iCount) to an element in [0, iCount): a four-round Feistel network
+	* on the smallest even bit width holding iCount, repeated until the result is in range (cycle walking).
+	*
+	* @param   Permutation_t* pPerm
+	* @param   uint64_t iIndex
+	* @return  uint64_t
+*/
+
+uint64_t permute(Permutation_t const* pPerm, uint64_t iIndex) {
+
+	do {
+
+		uint64_t iLeft = iIndex >> pPerm->iHalfBits;
+		uint64_t iRight = iIndex & pPerm->iMask;
+
+		for (unsigned int r = 0; r < 4; r++) {
+			uint64_t iNew = iLeft ^ (mix64(iRight ^ pPerm->aKeys[r]) & pPerm->iMask);
+			iLeft = iRight;
+			iRight = iNew;
+		}
+
+		iIndex = (iLeft << pPerm->iHalfBits) | iRight;
+	}
+	while (iIndex >= pPerm->iCount);
+
+	return iIndex;
+}
+
+
+/**
+	* Key a permutation of [0, iCount) for permute().
+	*
+	* @param   Permutation_t* pPerm, populated
+	* @param   uint64_t iCount
+	* @param   uint64_t iKey, e.g. the generator seed
+	* @return  void
+*/
+
+void permutationInit(Permutation_t* pPerm, uint64_t iCount, uint64_t iKey) {
+
+	memset(pPerm, 0, sizeof(Permutation_t));
+	pPerm->iCount = iCount;
+	pPerm->iHalfBits = 1;
+
+	while (pPerm->iHalfBits < 32 && (1ULL << (2 * pPerm->iHalfBits)) < iCount) {
+		pPerm->iHalfBits++;
+	}
+
+	pPerm->iMask = (1ULL << pPerm->iHalfBits) - 1;
+
+	for (unsigned int r = 0; r < 4; r++) {
+		pPerm->aKeys[r] = mix64(iKey + (r + 1) * 0x9E3779B97F4A7C15ULL);
+	}
+}
+
+
+#ifdef __linux
+
+
+/* defines */
+#define LATENCY_SUB 16            /* linear sub-buckets per power of two: ~6% resolution */
+#define LATENCY_BUCKETS (64 * LATENCY_SUB)
+
+
+/* constants */
+static uint64_t const cDIRECT_ALIGN = 4 * KB;  /* O_DIRECT offset and length alignment */
+static unsigned int const cQUEUE_DEPTH = 32;   /* default --qd */
+static uint64_t const cCLAIM = 16;             /* permutation indices claimed at a time */
+
+
+/* structs */
+typedef struct {
+	Options_t const* pOptions;
+	rnd64_ctx_t const* pCtx;
+	Arena_t* pArena;
+	Permutation_t perm;
+	int iFd;                   /* O_DIRECT where possible */
+	int iTailFd;               /* buffered: unaligned blocks */
+	int iDirect;
+	uint64_t iNext;            /* next permutation index to claim */
+	int iError;
+} RandomWrite_t;
+
+typedef struct {
+	RandomWrite_t* pShared;
+	uint64_t iBlocks;
+	uint64_t aLatency[LATENCY_BUCKETS]; /* write latency, ns */
+} RandomWorker_t;
+
+
+/**
+	* Histogram bucket of a latency: exact below 16 ns, then 16 linear steps per power of two.
+	*
+	* @param   uint64_t iNs
+	* @return  unsigned int
+*/
+
+static unsigned int latencyBucket(uint64_t iNs) {
+
+	if (iNs < LATENCY_SUB) {
+		return (unsigned int) iNs;
+	}
+
+	unsigned int iExp = 63 - (unsigned int) __builtin_clzll(iNs);
+
+	return (iExp - 3) * LATENCY_SUB + (unsigned int) ((iNs >> (iExp - 4)) & (LATENCY_SUB - 1));
+}
+
+
+/**
+	* Lower bound of a histogram bucket, ns.
+	*
+	* @param   unsigned int iBucket
+	* @return  uint64_t
+*/
+
+static uint64_t latencyValue(unsigned int iBucket) {
+
+	if (iBucket < LATENCY_SUB) {
+		return iBucket;
+	}
+
+	unsigned int iExp = iBucket / LATENCY_SUB + 3;
+
+	return (uint64_t) (LATENCY_SUB + iBucket % LATENCY_SUB) << (iExp - 4);
+}
+
+
+/**
+	* Thread function: claim permutation indices and write their blocks.
+	*
+	* @param   void pointer st, RandomWorker_t struct
+	* @return  void* / null
+*/
+
+static void* randomWorker(void* st) {
+
+	RandomWorker_t* pWorker = (RandomWorker_t*) st;
+	RandomWrite_t* pShared = pWorker->pShared;
+	uint64_t iSize = pShared->pOptions->iBytes;
+	uint64_t iBlock = pShared->pOptions->iBlock;
+	uint8_t* pBuffer = (uint8_t*) arenaAcquire(pShared->pArena);
+	rnd64_ctx_t* pCtx = rnd64_clone(pShared->pCtx);
+
+	if (pCtx == NULL) {
+		fprintf(stderr, "\n%s: generator initialisation failed.\n\n", pFilename);
+		__atomic_store_n(&pShared->iError, 1, __ATOMIC_RELAXED);
+	}
+
+	while (pCtx != NULL && ! __atomic_load_n(&pShared->iError, __ATOMIC_RELAXED)) {
+
+		uint64_t iFirst = __atomic_fetch_add(&pShared->iNext, cCLAIM, __ATOMIC_RELAXED);
+
+		if (iFirst >= pShared->perm.iCount) {
+			break;
+		}
+
+		uint64_t iLast = (iFirst + cCLAIM < pShared->perm.iCount) ? iFirst + cCLAIM : pShared->perm.iCount;
+
+		for (uint64_t i = iFirst; i < iLast; i++) {
+
+			uint64_t iOffset = permute(&pShared->perm, i) * iBlock;
+			size_t iLen = (iSize - iOffset < iBlock) ? (size_t) (iSize - iOffset) : (size_t) iBlock;
+			int iFd = (pShared->iDirect && iLen % cDIRECT_ALIGN == 0) ? pShared->iFd : pShared->iTailFd;
+
+			/* the block's own offset in the stream: same content as sequential output */
+			rnd64_seek(pCtx, iOffset);
+
+			if (rnd64_fill(pCtx, pBuffer, iLen) != 0) {
+				fprintf(stderr, "\n%s: insufficient crypto random bytes available.\n\n", pFilename);
+				__atomic_store_n(&pShared->iError, 1, __ATOMIC_RELAXED);
+				break;
+			}
+
+			double fStart = getTime();
+			size_t iDone = 0;
+
+			while (iDone < iLen) {
+
+				ssize_t iWritten = pwrite(iFd, pBuffer + iDone, iLen - iDone, (off_t) (iOffset + iDone));
+
+				if (iWritten < 0 && errno == EINTR) {
+					continue;
+				}
+
+				if (iWritten <= 0) {
+					fprintf(stderr, "\n%s: write failure at offset %"PRIu64" (%s).\n\n", pFilename, iOffset + iDone, strerror(errno));
+					__atomic_store_n(&pShared->iError, 1, __ATOMIC_RELAXED);
+					break;
+				}
+
+				iDone += (size_t) iWritten;
+			}
+
+			if (iDone < iLen) {
+				break;
+			}
+
+			pWorker->aLatency[latencyBucket((uint64_t) ((getTime() - fStart) * 1e9))]++;
+			pWorker->iBlocks++;
+		}
+	}
+
+	rnd64_destroy(pCtx);
+	arenaRelease(pShared->pArena, pBuffer);
+
+	return NULL;
+}
+
+
+/**
+	* Write <size> bytes to [file] in a seeded random block order.
+	*
+	* @param   Options_t* pOptions
+	* @return  int, EXIT_SUCCESS / EXIT_FAILURE
+*/
+
+int randomWrite(Options_t const* pOptions) {
+
+	unsigned int iWriters = (pOptions->iQueueDepth > 0) ? pOptions->iQueueDepth : cQUEUE_DEPTH;
+	uint64_t iBlock = pOptions->iBlock;
+	uint64_t aLatency[LATENCY_BUCKETS];
+	uint64_t iBlocks = 0;
+	RandomWrite_t shared;
+
+	memset(&shared, 0, sizeof(shared));
+	memset(aLatency, 0, sizeof(aLatency));
+
+	shared.pOptions = pOptions;
+	shared.perm.iCount = (pOptions->iBytes + iBlock - 1) / iBlock;
+
+	if (iWriters > shared.perm.iCount) {
+		iWriters = (unsigned int) shared.perm.iCount;
+	}
+
+	shared.iDirect = (iBlock % cDIRECT_ALIGN == 0);
+	shared.iFd = open(pOptions->sOutput, O_WRONLY | O_CREAT | O_TRUNC | (shared.iDirect ? O_DIRECT : 0), 0644);
+
+	if (shared.iFd < 0 && shared.iDirect && errno == EINVAL) { /* filesystem without O_DIRECT, e.g. tmpfs */
+		shared.iDirect = 0;
+		shared.iFd = open(pOptions->sOutput, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	}
+
+	shared.iTailFd = (shared.iFd >= 0) ? open(pOptions->sOutput, O_WRONLY) : -1;
+
+	if (shared.iFd < 0 || shared.iTailFd < 0) {
+		fprintf(stderr, "\n%s: output file cannot be written.\n(check write permissions / filename characters)\n\n", pFilename);
+
+		if (shared.iFd >= 0) {
+			close(shared.iFd);
+		}
+
+		return EXIT_FAILURE;
+	}
+
+	/* final size up front: blocks land inside the file in any order */
+	if (ftruncate(shared.iFd, (off_t) pOptions->iBytes) != 0) {
+		fprintf(stderr, "\n%s: output file cannot be sized (%s).\n\n", pFilename, strerror(errno));
+		close(shared.iTailFd);
+		close(shared.iFd);
+		return EXIT_FAILURE;
+	}
+
+	rnd64_ctx_t* pCtx = rnd64_create(pOptions->iMode, pOptions->iEngine, pOptions->iSeed);
+	RandomWorker_t* aWorkers = (RandomWorker_t*) calloc(iWriters, sizeof(RandomWorker_t));
+	pthread_t* aThreadID = (pthread_t*) calloc(iWriters, sizeof(pthread_t));
+	unsigned int iStarted = 0;
+
+	shared.pCtx = pCtx;
+	shared.pArena = arenaCreate((size_t) iBlock, iWriters);
+
+	if (pCtx == NULL || aWorkers == NULL || aThreadID == NULL || shared.pArena == NULL) {
+		fprintf(stderr, "\n%s: %s.\n\n", pFilename, (pCtx == NULL) ? "secure data generation unavailable" : "insufficient memory for write buffers");
+		arenaDestroy(shared.pArena);
+		free(aThreadID);
+		free(aWorkers);
+		rnd64_destroy(pCtx);
+		close(shared.iTailFd);
+		close(shared.iFd);
+		return EXIT_FAILURE;
+	}
+
+	/* permutation keyed by the seed */
+	permutationInit(&shared.perm, shared.perm.iCount, rnd64_seed(pCtx));
+
+	double fStart = getTime();
+
+	for (unsigned int i = 0; i < iWriters; i++) {
+
+		aWorkers[i].pShared = &shared;
+
+		/* stop the writers already running: the file would be left with unwritten blocks */
+		if (pthread_create(&aThreadID[i], NULL, randomWorker, &aWorkers[i]) != 0) {
+			fprintf(stderr, "\n%s: writer thread cannot be started.\n\n", pFilename);
+			__atomic_store_n(&shared.iError, 1, __ATOMIC_RELAXED);
+			break;
+		}
+
+		iStarted++;
+	}
+
+	for (unsigned int i = 0; i < iStarted; i++) {
+
+		pthread_join(aThreadID[i], NULL);
+
+		iBlocks += aWorkers[i].iBlocks;
+
+		for (unsigned int b = 0; b < LATENCY_BUCKETS; b++) {
+			aLatency[b] += aWorkers[i].aLatency[b];
+		}
+	}
+
+	if (fdatasync(shared.iFd) != 0) {
+		fprintf(stderr, "\n%s: sync failure (%s).\n\n", pFilename, strerror(errno));
+		shared.iError = 1;
+	}
+
+	double fTime = getTime() - fStart;
+
+	printf("\n%s generated (random order)\n\nsize: %"PRIu64" bytes\n", pOptions->sOutput, pOptions->iBytes);
+	printf("blocks: %"PRIu64" of %"PRIu64" bytes, queue depth %u, %s, seed 0x%016"PRIx64"\n", iBlocks, iBlock, iWriters, shared.iDirect ? "O_DIRECT" : "buffered", rnd64_seed(pCtx));
+	printf("time: %d s %d ms\n", (int) fTime, (int) (fTime * 1000) % 1000);
+
+	if (fTime > 0) {
+		printf("MB/s: %0.2f\n", (pOptions->iBytes * cMBRECIP * cMBRECIP) / fTime);
+		printf("IOPS: %0.0f\n", iBlocks / fTime);
+	}
+
+	/* percentiles from the histogram */
+	if (iBlocks > 0) {
+
+		unsigned int const aPerMille[] = {500, 900, 990, 999};
+		unsigned int p = 0;
+		unsigned int iMax = 0;
+		uint64_t iSeen = 0;
+
+		printf("latency (us):");
+
+		for (unsigned int b = 0; b < LATENCY_BUCKETS; b++) {
+
+			iSeen += aLatency[b];
+
+			/* nearest rank: the ceil(n * p / 100)th fastest block, in integers so 99.9 is exact */
+			while (p < sizeof(aPerMille) / sizeof(aPerMille[0]) && iSeen >= (iBlocks * aPerMille[p] + 999) / 1000) {
+				printf("  p%g %0.1f", aPerMille[p] / 10.0, latencyValue(b) / 1000.0);
+				p++;
+			}
+
+			if (aLatency[b] > 0) {
+				iMax = b;
+			}
+		}
+
+		printf("  max %0.1f\n", latencyValue(iMax) / 1000.0);
+	}
+
+	printf("\n");
+
+	arenaDestroy(shared.pArena);
+	free(aThreadID);
+	free(aWorkers);
+	rnd64_destroy(pCtx);
+	close(shared.iTailFd);
+	close(shared.iFd);
+
+	return shared.iError ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+
+#elif _WIN64
+
+
+/**
+	* Write in random block order (Linux only: O_DIRECT, positional writes).
+	*
+	* @param   Options_t* pOptions
+	* @return  int, EXIT_FAILURE
+*/
+
+int randomWrite(Options_t const* pOptions) {
+
+	(void) pOptions;
+	fprintf(stderr, "\n%s: --order random is not available on this platform.\n\n", pFilename);
+
+	return EXIT_FAILURE;
+}
+
+
+#endif
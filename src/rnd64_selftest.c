@@ -0,0 +1,828 @@
+/**
+	* RND64
+	* rnd64_selftest.c
+	*
+	* Statistical self-test: --selftest generates a large sample from each engine (-a, -r, -c) the way stream
+	* mode does, one seeked section per thread, and runs a quick battery over it in parallel.
+	*
+	* @author        Martin Latter
+	* @copyright     Martin Latter, April 2014
+	* @version       0.42 mt
+	* @license       GNU GPL version 3.0 (GPL v3); https://www.gnu.org/licenses/gpl-3.0.html
+	* @link          https://github.com/Tinram/RND64.git
+	*
+	* Tests: monobit, byte frequency, word (byte pair) frequency, gap, birthday spacings, and, between sections
+	* generated by different threads, correlation at equal offsets and shared content at any offset, which
+	* catch shared or mis-seeked generator state. Each result is reduced to a z-score: |z| > 3.5 is reported as weak,
+	* |z| > 5 fails the run.
+*/
+
+
+#include "rnd64.h"
+#include <math.h>
+
+
+#ifdef __linux
+
+
+/* constants */
+static size_t const cBLOCK = 1024 * KB;         /* generation unit */
+static size_t const cGAP_SPAN = 256 * KB;       /* gap test bytes per block */
+static size_t const cSAMPLE_SPAN = 4 * KB;      /* stream correlation bytes per sampled block */
+static unsigned int const cSAMPLE_BLOCKS = 64;  /* sampled blocks per section */
+static unsigned int const cSECTIONS_MIN = 4;    /* so a single-CPU run still compares streams */
+static unsigned int const cPAIRS_ALL = 32;      /* above this many sections, compare neighbours only */
+static unsigned int const cFLUSH = 4096;        /* blocks per 32-bit pair count: 4096 * 512 k < 2^32 */
+static double const cZ_WEAK = 3.5;
+static double const cZ_FAIL = 5.0;
+
+#define GAP_MAX 16                              /* gap lengths 0-15, and 16+ */
+#define BIRTHDAYS 4096                          /* birthdays per trial */
+#define BIRTHDAY_TRIALS 2                       /* trials per block, after the gap span */
+#define BIRTHDAY_MAX 6                          /* duplicate spacings 0-5, and 6+ */
+
+
+/* structs */
+typedef struct {
+	char const* sFlag;
+	char const* sName;
+	rnd64_mode_t iMode;
+	rnd64_engine_t iEngine;
+} SelfTestEngine_t;
+
+typedef struct {
+	rnd64_ctx_t const* pCtx;
+	Arena_t* pArena;
+	unsigned int iAlpha;         /* symbols: 256, or 94 characters */
+	uint8_t aIndex[256];         /* byte -> symbol index, 0xFF outside the alphabet */
+	unsigned int iSections;
+	unsigned int iNextSection;
+	uint64_t iBlocks;            /* per section */
+	unsigned int iSampleStride;  /* sample every iSampleStride-th block */
+	size_t iSampleLen;           /* bytes sampled per section */
+	uint8_t* pSamples;           /* iSections * iSampleLen */
+	int iError;
+} SelfTest_t;
+
+typedef struct {
+	SelfTest_t* pShared;
+	uint32_t aPairCount[256 * 256];
+	uint64_t aPairs[256 * 256];
+	uint64_t iInvalid;
+	uint64_t aGaps[GAP_MAX + 1];
+	uint64_t aBirthdays[BIRTHDAY_MAX + 1];
+	uint64_t aDays[BIRTHDAYS];
+	uint64_t aSort[BIRTHDAYS];
+} SelfTestWorker_t;
+
+typedef struct {
+	uint64_t iWindow;
+	unsigned int iSection;
+} Anchor_t;
+
+
+static SelfTestEngine_t const aEngines[] = {
+	{"-a", "PCG32, bytes 0-255", RND64_MODE_ALL, RND64_ENGINE_PCG32},
+	{"-r", "PCG32, characters 33-126", RND64_MODE_RESTRICTED, RND64_ENGINE_PCG32},
+	{"-c", "crypto, bytes 0-255", RND64_MODE_ALL, RND64_ENGINE_CRYPTO}
+};
+
+
+/**
+	* LSD radix sort of values below 2^36: four 9-bit passes, so the result ends in aValues.
+	*
+	* @param   uint64_t* aValues
+	* @param   uint64_t* aTemp, same length
+	* @param   size_t iLen
+	* @return  void
+*/
+
+static void radixSort(uint64_t* aValues, uint64_t* aTemp, size_t iLen) {
+
+	uint64_t* pFrom = aValues;
+	uint64_t* pTo = aTemp;
+
+	for (unsigned int iShift = 0; iShift < 36; iShift += 9) {
+
+		size_t aCount[512];
+		size_t iSum = 0;
+
+		memset(aCount, 0, sizeof(aCount));
+
+		for (size_t i = 0; i < iLen; i++) {
+			aCount[(pFrom[i] >> iShift) & 511]++;
+		}
+
+		for (unsigned int d = 0; d < 512; d++) {
+			size_t iCount = aCount[d];
+			aCount[d] = iSum;
+			iSum += iCount;
+		}
+
+		for (size_t i = 0; i < iLen; i++) {
+			pTo[aCount[(pFrom[i] >> iShift) & 511]++] = pFrom[i];
+		}
+
+		uint64_t* pSwap = pFrom;
+		pFrom = pTo;
+		pTo = pSwap;
+	}
+}
+
+
+/**
+	* Run the per-block tests: pair counts, gaps, and birthday spacings trials.
+	*
+	* @param   SelfTestWorker_t* pWorker
+	* @param   uint8_t* pData, cBLOCK bytes
+	* @return  void
+*/
+
+static void testBlock(SelfTestWorker_t* pWorker, uint8_t const* pData) {
+
+	SelfTest_t const* pShared = pWorker->pShared;
+	uint8_t const* aIndex = pShared->aIndex;
+	unsigned int iAlpha = pShared->iAlpha;
+	unsigned int iHalf = iAlpha / 2;
+
+	/* symbol pairs: word frequency, and byte frequency as its marginals */
+	if (iAlpha == 256) {
+
+		for (size_t i = 0; i < cBLOCK; i += 2) {
+			pWorker->aPairCount[(unsigned int) pData[i] << 8 | pData[i + 1]]++;
+		}
+	}
+	else {
+
+		for (size_t i = 0; i < cBLOCK; i += 2) {
+
+			unsigned int iFirst = aIndex[pData[i]];
+			unsigned int iSecond = aIndex[pData[i + 1]];
+
+			if (iFirst >= iAlpha || iSecond >= iAlpha) {
+				pWorker->iInvalid++;
+			}
+			else {
+				pWorker->aPairCount[iFirst * iAlpha + iSecond]++;
+			}
+		}
+	}
+
+	/*
+		* gaps after symbols in the lower half of the alphabet, from hit bitmasks rather than a per-byte branch
+		* (hits are a coin toss): gaps of length k = hits followed by k misses and a hit, counted 64 at a time
+	*/
+	uint64_t aMask[cGAP_SPAN / 64];
+
+	for (size_t w = 0; w < cGAP_SPAN / 64; w++) {
+
+		uint64_t iMask = 0;
+
+		for (unsigned int b = 0; b < 64; b++) {
+			iMask |= (uint64_t) (aIndex[pData[w * 64 + b]] < iHalf) << b;
+		}
+
+		aMask[w] = iMask;
+	}
+
+	for (size_t w = 0; w + 1 < cGAP_SPAN / 64; w++) { /* the last word is lookahead only */
+
+		unsigned __int128 iHits = (unsigned __int128) aMask[w] | (unsigned __int128) aMask[w + 1] << 64;
+		uint64_t iMisses = ~0ULL;
+
+		for (unsigned int k = 0; k < GAP_MAX; k++) {
+			uint64_t iNext = (uint64_t) (iHits >> (k + 1));
+			pWorker->aGaps[k] += (uint64_t) __builtin_popcountll(aMask[w] & iMisses & iNext);
+			iMisses &= ~iNext;
+		}
+
+		pWorker->aGaps[GAP_MAX] += (uint64_t) __builtin_popcountll(aMask[w] & iMisses);
+	}
+
+	/* birthday spacings, after the gap span: 32-bit days from 4 bytes, or 94^5 days from 5 characters */
+	unsigned int iWidth = (iAlpha == 256) ? 4 : 5;
+
+	for (unsigned int t = 0; t < BIRTHDAY_TRIALS; t++) {
+
+		uint8_t const* pDays = pData + cGAP_SPAN + t * BIRTHDAYS * iWidth;
+		unsigned int iDuplicates = 0;
+
+		for (unsigned int b = 0; b < BIRTHDAYS; b++) {
+
+			uint64_t iDay = 0;
+
+			for (unsigned int k = 0; k < iWidth; k++) {
+				uint8_t iSymbol = aIndex[pDays[b * iWidth + k]];
+				iDay = iDay * iAlpha + ((iSymbol < iAlpha) ? iSymbol : 0);
+			}
+
+			pWorker->aDays[b] = iDay;
+		}
+
+		radixSort(pWorker->aDays, pWorker->aSort, BIRTHDAYS);
+
+		for (unsigned int b = BIRTHDAYS - 1; b > 0; b--) {
+			pWorker->aDays[b] -= pWorker->aDays[b - 1];
+		}
+
+		radixSort(pWorker->aDays, pWorker->aSort, BIRTHDAYS);
+
+		for (unsigned int b = 1; b < BIRTHDAYS; b++) {
+			iDuplicates += (pWorker->aDays[b] == pWorker->aDays[b - 1]);
+		}
+
+		pWorker->aBirthdays[(iDuplicates < BIRTHDAY_MAX) ? iDuplicates : BIRTHDAY_MAX]++;
+	}
+}
+
+
+/**
+	* Move the 32-bit pair counts into the 64-bit totals.
+	*
+	* @param   SelfTestWorker_t* pWorker
+	* @return  void
+*/
+
+static void flushPairs(SelfTestWorker_t* pWorker) {
+
+	unsigned int iCells = pWorker->pShared->iAlpha * pWorker->pShared->iAlpha;
+
+	for (unsigned int c = 0; c < iCells; c++) {
+		pWorker->aPairs[c] += pWorker->aPairCount[c];
+		pWorker->aPairCount[c] = 0;
+	}
+}
+
+
+/**
+	* Thread function: generate and test whole sections, each from its own context seeked to the section
+	* start, as stream mode threads do.
+	*
+	* @param   void pointer st, SelfTestWorker_t struct
+	* @return  void* / null
+*/
+
+static void* selfTestWorker(void* st) {
+
+	SelfTestWorker_t* pWorker = (SelfTestWorker_t*) st;
+	SelfTest_t* pShared = pWorker->pShared;
+	uint8_t* pBuffer = (uint8_t*) arenaAcquire(pShared->pArena);
+	uint64_t iSinceFlush = 0;
+
+	for (;;) {
+
+		unsigned int iSection = __atomic_fetch_add(&pShared->iNextSection, 1, __ATOMIC_RELAXED);
+
+		if (iSection >= pShared->iSections) {
+			break;
+		}
+
+		rnd64_ctx_t* pCtx = rnd64_clone(pShared->pCtx);
+
+		if (pCtx == NULL) {
+			__atomic_store_n(&pShared->iError, 1, __ATOMIC_RELAXED);
+			break;
+		}
+
+		rnd64_seek(pCtx, iSection * pShared->iBlocks * cBLOCK);
+
+		uint8_t* pSample = pShared->pSamples + iSection * pShared->iSampleLen;
+
+		for (uint64_t b = 0; b < pShared->iBlocks; b++) {
+
+			if (rnd64_fill(pCtx, pBuffer, cBLOCK) != 0) {
+				__atomic_store_n(&pShared->iError, 1, __ATOMIC_RELAXED);
+				break;
+			}
+
+			testBlock(pWorker, pBuffer);
+
+			if (b % pShared->iSampleStride == 0 && b / pShared->iSampleStride < cSAMPLE_BLOCKS) {
+				memcpy(pSample + (b / pShared->iSampleStride) * cSAMPLE_SPAN, pBuffer, cSAMPLE_SPAN);
+			}
+
+			if (++iSinceFlush == cFLUSH) {
+				flushPairs(pWorker);
+				iSinceFlush = 0;
+			}
+		}
+
+		rnd64_destroy(pCtx);
+	}
+
+	flushPairs(pWorker);
+	arenaRelease(pShared->pArena, pBuffer);
+
+	return NULL;
+}
+
+
+/**
+	* Sort anchors by value.
+	*
+	* @param   void* pA
+	* @param   void* pB
+	* @return  int
+*/
+
+static int compareAnchors(void const* pA, void const* pB) {
+
+	uint64_t iA = ((Anchor_t const*) pA)->iWindow;
+	uint64_t iB = ((Anchor_t const*) pB)->iWindow;
+
+	return (iA > iB) - (iA < iB);
+}
+
+
+/**
+	* Count 8-byte windows found in the samples of more than one section.
+	* Windows are anchored by content (1 in 64 by hash), so a copy of a stream at any byte shift has the same
+	* anchors; for independent streams a shared 64-bit window is practically impossible.
+	*
+	* @param   SelfTest_t* pShared
+	* @return  uint64_t, shared windows, UINT64_MAX if out of memory
+*/
+
+static uint64_t countShared(SelfTest_t const* pShared) {
+
+	size_t iMax = pShared->iSections * (pShared->iSampleLen / 16);
+	size_t iAnchors = 0;
+	uint64_t iShared = 0;
+	Anchor_t* aAnchors = (Anchor_t*) malloc(iMax * sizeof(Anchor_t));
+
+	if (aAnchors == NULL) {
+		return UINT64_MAX;
+	}
+
+	for (unsigned int i = 0; i < pShared->iSections; i++) {
+
+		uint8_t const* pSample = pShared->pSamples + i * pShared->iSampleLen;
+
+		for (size_t k = 0; k + 8 <= pShared->iSampleLen && iAnchors < iMax; k++) {
+
+			uint64_t iWindow;
+			memcpy(&iWindow, pSample + k, 8);
+
+			if ((iWindow * 0x9E3779B97F4A7C15ULL) >> 58 == 0) {
+				aAnchors[iAnchors].iWindow = iWindow;
+				aAnchors[iAnchors].iSection = i;
+				iAnchors++;
+			}
+		}
+	}
+
+	qsort(aAnchors, iAnchors, sizeof(Anchor_t), compareAnchors);
+
+	for (size_t k = 1; k < iAnchors; k++) {
+		iShared += (aAnchors[k].iWindow == aAnchors[k - 1].iWindow && aAnchors[k].iSection != aAnchors[k - 1].iSection);
+	}
+
+	free(aAnchors);
+
+	return iShared;
+}
+
+
+/**
+	* Normal deviate of a chi-square statistic (Wilson-Hilferty).
+	*
+	* @param   double fChi
+	* @param   double fDof, degrees of freedom
+	* @return  double
+*/
+
+static double chiZ(double fChi, double fDof) {
+
+	double fVar = 2 / (9 * fDof);
+
+	return (cbrt(fChi / fDof) - (1 - fVar)) / sqrt(fVar);
+}
+
+
+/**
+	* Chi-square of observed counts against expected probabilities.
+	*
+	* @param   uint64_t* aObserved
+	* @param   double* aProb
+	* @param   unsigned int iCells
+	* @param   double* pMinExpected, smallest expected count, for validity
+	* @return  double
+*/
+
+static double chiSquare(uint64_t const* aObserved, double const* aProb, unsigned int iCells, double* pMinExpected) {
+
+	double fTotal = 0;
+	double fChi = 0;
+
+	for (unsigned int c = 0; c < iCells; c++) {
+		fTotal += (double) aObserved[c];
+	}
+
+	*pMinExpected = fTotal;
+
+	for (unsigned int c = 0; c < iCells; c++) {
+
+		double fExpected = fTotal * aProb[c];
+		double fDiff = (double) aObserved[c] - fExpected;
+
+		fChi += fDiff * fDiff / fExpected;
+
+		if (fExpected < *pMinExpected) {
+			*pMinExpected = fExpected;
+		}
+	}
+
+	return fChi;
+}
+
+
+/**
+	* Print one result line and classify it.
+	*
+	* @param   char* sTest
+	* @param   char* sDetail
+	* @param   double fZ
+	* @return  int, 1 if the test failed
+*/
+
+static int report(char const* sTest, char const* sDetail, double fZ) {
+
+	double fAbs = fabs(fZ);
+	char const* sVerdict = (fAbs > cZ_FAIL || fZ != fZ) ? "FAIL" : (fAbs > cZ_WEAK) ? "weak" : "pass";
+
+	printf("    %-20s %-38s z = %7.2f   %s\n", sTest, sDetail, fZ, sVerdict);
+
+	return sVerdict[0] == 'F';
+}
+
+
+/**
+	* Print a test that could not run.
+	*
+	* @param   char* sTest
+	* @param   char* sReason
+	* @return  void
+*/
+
+static void skip(char const* sTest, char const* sReason) {
+
+	printf("    %-20s %-38s             skipped\n", sTest, sReason);
+}
+
+
+/**
+	* Generate and test one engine.
+	*
+	* @param   Options_t* pOptions
+	* @param   SelfTestEngine_t* pEngine
+	* @param   unsigned int* pTests, incremented per test run
+	* @return  int, failed tests, or -1 on error (message printed)
+*/
+
+static int testEngine(Options_t const* pOptions, SelfTestEngine_t const* pEngine, unsigned int* pTests) {
+
+	unsigned int iNumThreads = pOptions->iThreads;
+	unsigned int iStarted = 0;
+	unsigned int iFailed = 0;
+	pthread_t rThreadID[iNumThreads];
+	SelfTestWorker_t* aWorkers = NULL;
+	SelfTest_t shared;
+	char sDetail[64];
+
+	memset(&shared, 0, sizeof(shared));
+
+	shared.iSections = (iNumThreads < cSECTIONS_MIN) ? cSECTIONS_MIN : iNumThreads;
+	shared.iBlocks = pOptions->iBytes / (shared.iSections * cBLOCK);
+
+	if (shared.iBlocks == 0) {
+		shared.iBlocks = 1;
+	}
+
+	shared.iSampleStride = (unsigned int) ((shared.iBlocks + cSAMPLE_BLOCKS - 1) / cSAMPLE_BLOCKS);
+	shared.iSampleLen = ((shared.iBlocks < cSAMPLE_BLOCKS) ? shared.iBlocks : cSAMPLE_BLOCKS) * cSAMPLE_SPAN;
+	shared.iAlpha = (pEngine->iMode == RND64_MODE_RESTRICTED) ? 94 : 256;
+
+	for (unsigned int c = 0; c < 256; c++) {
+		shared.aIndex[c] = (shared.iAlpha == 256) ? c : (c >= 33 && c <= 126) ? c - 33 : 0xFF;
+	}
+
+	rnd64_ctx_t* pCtx = rnd64_create(pEngine->iMode, pEngine->iEngine, pOptions->iSeed);
+
+	if (pCtx == NULL) {
+		fprintf(stderr, "\n%s: %s: generator unavailable.\n\n", pFilename, pEngine->sFlag);
+		return -1;
+	}
+
+	shared.pCtx = pCtx;
+	shared.pArena = arenaCreate(cBLOCK, iNumThreads);
+	shared.pSamples = (uint8_t*) malloc(shared.iSections * shared.iSampleLen);
+	aWorkers = (SelfTestWorker_t*) calloc(iNumThreads, sizeof(SelfTestWorker_t));
+
+	if (shared.pArena == NULL || shared.pSamples == NULL || aWorkers == NULL) {
+		fprintf(stderr, "\n%s: insufficient memory for the self-test.\n\n", pFilename);
+		free(aWorkers);
+		free(shared.pSamples);
+		arenaDestroy(shared.pArena);
+		rnd64_destroy(pCtx);
+		return -1;
+	}
+
+	uint64_t iTotal = shared.iSections * shared.iBlocks * cBLOCK;
+
+	if (pEngine->iEngine == RND64_ENGINE_PCG32) {
+		printf("\n%s  %s, seed 0x%016"PRIx64"\n\n", pEngine->sFlag, pEngine->sName, rnd64_seed(pCtx));
+	}
+	else {
+		printf("\n%s  %s\n\n", pEngine->sFlag, pEngine->sName);
+	}
+
+	double fStart = getTime();
+
+	for (unsigned int i = 0; i < iNumThreads; i++) {
+
+		aWorkers[i].pShared = &shared;
+
+		if (pthread_create(&rThreadID[i], NULL, selfTestWorker, &aWorkers[i]) != 0) {
+			fprintf(stderr, "\n%s: test thread cannot be started.\n\n", pFilename);
+			__atomic_store_n(&shared.iError, 1, __ATOMIC_RELAXED);
+			break;
+		}
+
+		iStarted++;
+	}
+
+	for (unsigned int i = 0; i < iStarted; i++) {
+		pthread_join(rThreadID[i], NULL);
+	}
+
+	/* merge into worker 0 */
+	for (unsigned int i = 1; i < iNumThreads; i++) {
+
+		for (unsigned int c = 0; c < 256 * 256; c++) {
+			aWorkers[0].aPairs[c] += aWorkers[i].aPairs[c];
+		}
+
+		for (unsigned int c = 0; c <= GAP_MAX; c++) {
+			aWorkers[0].aGaps[c] += aWorkers[i].aGaps[c];
+		}
+
+		for (unsigned int c = 0; c <= BIRTHDAY_MAX; c++) {
+			aWorkers[0].aBirthdays[c] += aWorkers[i].aBirthdays[c];
+		}
+
+		aWorkers[0].iInvalid += aWorkers[i].iInvalid;
+	}
+
+	if (shared.iError) {
+		fprintf(stderr, "\n%s: %s: generation failed.\n\n", pFilename, pEngine->sFlag);
+		free(aWorkers);
+		free(shared.pSamples);
+		arenaDestroy(shared.pArena);
+		rnd64_destroy(pCtx);
+		return -1;
+	}
+
+	SelfTestWorker_t* pStats = &aWorkers[0];
+	unsigned int iAlpha = shared.iAlpha;
+	unsigned int iCells = iAlpha * iAlpha;
+	uint64_t aHist[256];
+	double aProb[256];
+	double fMinExpected = 0;
+	double fChi = 0;
+
+	/* out of range output */
+	if (pStats->iInvalid > 0) {
+		snprintf(sDetail, sizeof(sDetail), "%"PRIu64" pairs outside 33-126", pStats->iInvalid);
+		iFailed += report("character range", sDetail, INFINITY);
+		(*pTests)++;
+	}
+
+	memset(aHist, 0, sizeof(aHist));
+
+	for (unsigned int a = 0; a < iAlpha; a++) {
+		for (unsigned int b = 0; b < iAlpha; b++) {
+			aHist[a] += pStats->aPairs[a * iAlpha + b];
+			aHist[b] += pStats->aPairs[a * iAlpha + b];
+		}
+	}
+
+	/* monobit, from the byte counts */
+	if (iAlpha == 256) {
+
+		double fOnes = 0;
+		double fBits = 0;
+
+		for (unsigned int c = 0; c < 256; c++) {
+			fOnes += (double) aHist[c] * __builtin_popcount(c);
+			fBits += (double) aHist[c] * 8;
+		}
+
+		snprintf(sDetail, sizeof(sDetail), "ones %0.6f", fOnes / fBits);
+		iFailed += report("monobit", sDetail, (2 * fOnes - fBits) / sqrt(fBits));
+		(*pTests)++;
+	}
+
+	/* byte frequency */
+	for (unsigned int c = 0; c < iAlpha; c++) {
+		aProb[c] = 1.0 / iAlpha;
+	}
+
+	fChi = chiSquare(aHist, aProb, iAlpha, &fMinExpected);
+	snprintf(sDetail, sizeof(sDetail), "chi-square %0.1f, %u dof", fChi, iAlpha - 1);
+	iFailed += report((iAlpha == 256) ? "byte frequency" : "character frequency", sDetail, chiZ(fChi, iAlpha - 1));
+	(*pTests)++;
+
+	/* word frequency: uniform cells, so the chi-square is computed directly */
+	double fPairTotal = 0;
+	double fPairChi = 0;
+
+	for (unsigned int c = 0; c < iCells; c++) {
+		fPairTotal += (double) pStats->aPairs[c];
+	}
+
+	if (fPairTotal / iCells >= 5) {
+
+		for (unsigned int c = 0; c < iCells; c++) {
+			double fDiff = (double) pStats->aPairs[c] - fPairTotal / iCells;
+			fPairChi += fDiff * fDiff;
+		}
+
+		fPairChi /= fPairTotal / iCells;
+		snprintf(sDetail, sizeof(sDetail), "chi-square %0.1f, %u dof", fPairChi, iCells - 1);
+		iFailed += report((iAlpha == 256) ? "word frequency" : "pair frequency", sDetail, chiZ(fPairChi, iCells - 1));
+		(*pTests)++;
+	}
+	else {
+		skip((iAlpha == 256) ? "word frequency" : "pair frequency", "sample too small");
+	}
+
+	/* gap: geometric, p = 1/2 */
+	for (unsigned int c = 0; c < GAP_MAX; c++) {
+		aProb[c] = pow(0.5, c + 1);
+	}
+
+	aProb[GAP_MAX] = pow(0.5, GAP_MAX);
+
+	fChi = chiSquare(pStats->aGaps, aProb, GAP_MAX + 1, &fMinExpected);
+
+	if (fMinExpected >= 5) {
+		snprintf(sDetail, sizeof(sDetail), "chi-square %0.1f, %u dof", fChi, GAP_MAX);
+		iFailed += report("gap", sDetail, chiZ(fChi, GAP_MAX));
+		(*pTests)++;
+	}
+	else {
+		skip("gap", "sample too small");
+	}
+
+	/* birthday spacings: duplicates are Poisson, lambda = m^3 / 4n */
+	double fDays = (iAlpha == 256) ? 4294967296.0 : pow(94, 5);
+	double fLambda = pow(BIRTHDAYS, 3) / (4 * fDays);
+	double fTail = 1;
+
+	for (unsigned int c = 0; c < BIRTHDAY_MAX; c++) {
+		aProb[c] = exp(-fLambda) * pow(fLambda, c) / tgamma(c + 1);
+		fTail -= aProb[c];
+	}
+
+	aProb[BIRTHDAY_MAX] = fTail;
+
+	fChi = chiSquare(pStats->aBirthdays, aProb, BIRTHDAY_MAX + 1, &fMinExpected);
+
+	if (fMinExpected >= 5) {
+		snprintf(sDetail, sizeof(sDetail), "chi-square %0.1f, %u dof, lambda %0.2f", fChi, BIRTHDAY_MAX, fLambda);
+		iFailed += report("birthday spacings", sDetail, chiZ(fChi, BIRTHDAY_MAX));
+		(*pTests)++;
+	}
+	else {
+		skip("birthday spacings", "sample too small");
+	}
+
+	/* stream correlation: Pearson r of sections at equal offsets; r * sqrt(n) is normal if independent */
+	double fN = (double) shared.iSampleLen;
+	double fWorstZ = 0;
+	double fWorstR = 0;
+	unsigned int iPairs = 0;
+
+	for (unsigned int i = 0; i < shared.iSections; i++) {
+
+		unsigned int iLastJ = (shared.iSections <= cPAIRS_ALL) ? shared.iSections : ((i + 2 < shared.iSections) ? i + 2 : shared.iSections);
+
+		for (unsigned int j = i + 1; j < iLastJ; j++) {
+
+			uint8_t const* pX = shared.pSamples + i * shared.iSampleLen;
+			uint8_t const* pY = shared.pSamples + j * shared.iSampleLen;
+			uint64_t iSumX = 0, iSumY = 0, iSumXX = 0, iSumYY = 0, iSumXY = 0;
+
+			for (size_t k = 0; k < shared.iSampleLen; k++) {
+				iSumX += pX[k];
+				iSumY += pY[k];
+				iSumXX += (uint32_t) pX[k] * pX[k];
+				iSumYY += (uint32_t) pY[k] * pY[k];
+				iSumXY += (uint32_t) pX[k] * pY[k];
+			}
+
+			double fCov = fN * iSumXY - (double) iSumX * iSumY;
+			double fVarX = fN * iSumXX - (double) iSumX * iSumX;
+			double fVarY = fN * iSumYY - (double) iSumY * iSumY;
+			double fR = (fVarX > 0 && fVarY > 0) ? fCov / sqrt(fVarX * fVarY) : 1;
+			double fZ = fR * sqrt(fN);
+
+			if (fabs(fZ) >= fabs(fWorstZ)) {
+				fWorstZ = fZ;
+				fWorstR = fR;
+			}
+
+			iPairs++;
+		}
+	}
+
+	snprintf(sDetail, sizeof(sDetail), "worst r %0.5f, %u stream pairs", fWorstR, iPairs);
+	iFailed += report("stream correlation", sDetail, fWorstZ);
+	(*pTests)++;
+
+	/* stream overlap: shifted copies of one stream correlate at no fixed offset, but share anchor windows */
+	uint64_t iShared = countShared(&shared);
+
+	snprintf(sDetail, sizeof(sDetail), "%"PRIu64" windows in two streams", iShared);
+	iFailed += report("stream overlap", sDetail, (iShared > 0) ? INFINITY : 0);
+	(*pTests)++;
+
+	double fTime = getTime() - fStart;
+
+	printf("\n    %"PRIu64" bytes, %u streams, %u threads, %0.2f s", iTotal, shared.iSections, iNumThreads, fTime);
+
+	if (fTime > 0) {
+		printf(", %0.2f MB/s", (iTotal * cMBRECIP * cMBRECIP) / fTime);
+	}
+
+	printf("\n");
+
+	free(aWorkers);
+	free(shared.pSamples);
+	arenaDestroy(shared.pArena);
+	rnd64_destroy(pCtx);
+
+	return (int) iFailed;
+}
+
+
+/**
+	* Self-test every engine, or the one given with -a / -r / -c.
+	*
+	* @param   Options_t* pOptions
+	* @return  int, EXIT_SUCCESS / EXIT_FAILURE
+*/
+
+int selfTest(Options_t const* pOptions) {
+
+	unsigned int iTests = 0;
+	unsigned int iFailed = 0;
+
+	printf("\n%s self-test: %"PRIu64" bytes per engine, kernels: %s\n", pFilename, pOptions->iBytes, rnd64_isa());
+
+	for (unsigned int e = 0; e < sizeof(aEngines) / sizeof(aEngines[0]); e++) {
+
+		if (pOptions->iSelfTest == 2 && (aEngines[e].iMode != pOptions->iMode || aEngines[e].iEngine != pOptions->iEngine)) {
+			continue;
+		}
+
+		int iResult = testEngine(pOptions, &aEngines[e], &iTests);
+
+		if (iResult < 0) {
+			return EXIT_FAILURE;
+		}
+
+		iFailed += (unsigned int) iResult;
+	}
+
+	if (iFailed > 0) {
+		fprintf(stderr, "\n%s: SELF-TEST FAILED: %u of %u tests.\n\n", pFilename, iFailed, iTests);
+		return EXIT_FAILURE;
+	}
+
+	printf("\nself-test passed: %u tests\n\n", iTests);
+
+	return EXIT_SUCCESS;
+}
+
+
+#elif _WIN64
+
+
+/**
+	* Self-test the engines (Linux only: pthreads).
+	*
+	* @param   Options_t* pOptions
+	* @return  int, EXIT_FAILURE
+*/
+
+int selfTest(Options_t const* pOptions) {
+
+	(void) pOptions;
+	fprintf(stderr, "\n%s: --selftest is not available on this platform.\n\n", pFilename);
+
+	return EXIT_FAILURE;
+}
+
+
+#endif
@@ -0,0 +1,414 @@
+/**
+	* RND64
+	* rnd64_stress.c
+	*
+	* Output-free sink and burn-in: --sink=none generates without writing, for <size> or --duration, so the
+	* figure is pure generation throughput; --memstress also streams the buffers through a large working set.
+	*
+	* @author        Martin Latter
+	* @copyright     Martin Latter, April 2014
+	* @version       0.42 mt
+	* @license       GNU GPL version 3.0 (GPL v3); https://www.gnu.org/licenses/gpl-3.0.html
+	* @link          https://github.com/Tinram/RND64.git
+	*
+	* Threads are pinned one per CPU, and per-thread MB/s is printed every cSTRESS_INTERVAL seconds, so a
+	* throttling or degraded core shows as a slow column. In --memstress, each thread cycles through its slice
+	* of the working set buffer by buffer: every slot is checksummed when filled and verified when next
+	* visited, so memory errors are counted as well as loading the memory subsystem.
+*/
+
+
+#define _GNU_SOURCE /* pthread_setaffinity_np() */
+
+#include "rnd64.h"
+
+#ifdef __linux
+	#include <sched.h>
+#endif
+
+
+#ifdef __linux
+
+
+/* constants */
+static unsigned int const cSTRESS_INTERVAL = 10; /* seconds between per-thread reports */
+static unsigned int const cSTRESS_POLL = 100;    /* ms between stop checks */
+static unsigned int const cSTRESS_ERRORS = 8;    /* memory errors printed per thread */
+
+
+/* structs */
+typedef struct {
+	rnd64_ctx_t* pCtx;
+	uint8_t* pBuffer;          /* arena buffer, or working set slice for --memstress */
+	unsigned int iBuffer;
+	uint64_t iBytes;           /* section length, 0 = until stopped */
+	size_t iSlots;             /* --memstress: buffers in the slice, 0 = off */
+	uint64_t* aSums;           /* --memstress: checksum per slot */
+	int iCpu;                  /* -1 = not pinned */
+	unsigned int iThread;
+	int* pStop;
+	unsigned int* pFinished;
+	uint64_t iDone;            /* bytes generated, read by the reporter */
+	uint64_t iErrors;          /* --memstress checksum mismatches */
+	int iFailed;
+} StressWorker_t;
+
+
+/**
+	* Checksum a slot: 64-bit word sum, which changes with any single flipped bit.
+	*
+	* @param   uint8_t* pData
+	* @param   size_t iLen, multiple of 8
+	* @return  uint64_t
+*/
+
+static uint64_t slotSum(uint8_t const* pData, size_t iLen) {
+
+	uint64_t const* pWords = (uint64_t const*) pData;
+	uint64_t iSum = 0;
+
+	for (size_t i = 0; i < iLen / 8; i++) {
+		iSum += pWords[i];
+	}
+
+	return iSum;
+}
+
+
+/**
+	* Thread function: generate until the section is done or the run is stopped.
+	*
+	* @param   void pointer st, StressWorker_t struct
+	* @return  void* / null
+*/
+
+static void* stressWorker(void* st) {
+
+	StressWorker_t* pWorker = (StressWorker_t*) st;
+	size_t iSlot = 0;
+	uint64_t iDone = 0;
+
+	if (pWorker->iCpu >= 0) {
+
+		cpu_set_t rCpus;
+
+		CPU_ZERO(&rCpus);
+		CPU_SET(pWorker->iCpu, &rCpus);
+		pthread_setaffinity_np(pthread_self(), sizeof(rCpus), &rCpus);
+	}
+
+	while ( ! __atomic_load_n(pWorker->pStop, __ATOMIC_RELAXED)) {
+
+		uint64_t iLen = pWorker->iBuffer;
+		uint8_t* pOut = pWorker->pBuffer;
+
+		if (pWorker->iBytes > 0) {
+
+			if (iDone >= pWorker->iBytes) {
+				break;
+			}
+
+			if (pWorker->iBytes - iDone < iLen) {
+				iLen = pWorker->iBytes - iDone;
+			}
+		}
+
+		if (pWorker->iSlots > 0) {
+
+			pOut = pWorker->pBuffer + iSlot * pWorker->iBuffer;
+
+			if (slotSum(pOut, pWorker->iBuffer) != pWorker->aSums[iSlot]) {
+
+				if (pWorker->iErrors < cSTRESS_ERRORS) {
+					fprintf(stderr, "\n%s: thread %u: memory error in working set slot %zu.\n", pFilename, pWorker->iThread, iSlot);
+				}
+
+				pWorker->iErrors++;
+			}
+		}
+
+		if (rnd64_fill(pWorker->pCtx, pOut, (size_t) iLen) != 0) {
+			fprintf(stderr, "\n%s: insufficient crypto random bytes available.\n\n", pFilename);
+			pWorker->iFailed = 1;
+			break;
+		}
+
+		if (pWorker->iSlots > 0) {
+			pWorker->aSums[iSlot] = slotSum(pOut, pWorker->iBuffer);
+			iSlot = (iSlot + 1 == pWorker->iSlots) ? 0 : iSlot + 1;
+		}
+
+		iDone += iLen;
+		__atomic_store_n(&pWorker->iDone, iDone, __ATOMIC_RELAXED);
+	}
+
+	__atomic_add_fetch(pWorker->pFinished, 1, __ATOMIC_RELEASE);
+
+	return NULL;
+}
+
+
+/**
+	* Engine description for the banner.
+	*
+	* @param   Options_t* pOptions
+	* @return  char*
+*/
+
+static char const* stressEngine(Options_t const* pOptions) {
+
+	if (pOptions->iEngine == RND64_ENGINE_CRYPTO) {
+		return "-c (crypto)";
+	}
+
+	return (pOptions->iMode == RND64_MODE_SINGLE) ? "-f (null bytes)" : (pOptions->iMode == RND64_MODE_RESTRICTED) ? "-r (PCG32, characters)" : "-a (PCG32, bytes)";
+}
+
+
+/**
+	* Generate with no output for <size> or --duration, reporting per-thread throughput.
+	*
+	* @param   Options_t* pOptions
+	* @return  int, EXIT_SUCCESS / EXIT_FAILURE
+*/
+
+int stress(Options_t const* pOptions) {
+
+	unsigned int iNumThreads = pOptions->iThreads;
+	unsigned int iBuffer = pOptions->iBuffer;
+	unsigned int iFinished = 0;
+	unsigned int iStarted = 0;
+	int iStop = 0;
+	int iResult = EXIT_SUCCESS;
+	uint64_t iThreadBytes = pOptions->iBytes / iNumThreads;
+	uint64_t iTotal = 0;
+	uint64_t iErrors = 0;
+	size_t iSlice = iBuffer;
+	int aCpus[CPU_SETSIZE];
+	unsigned int iCpus = 0;
+	cpu_set_t rAllowed;
+
+	pthread_t rThreadID[iNumThreads];
+	StressWorker_t aWorkers[iNumThreads];
+	uint64_t aLast[iNumThreads];
+
+	rnd64_ctx_t* pCtx = NULL;
+	Arena_t* pArena = NULL;
+	uint64_t* aSums = NULL;
+
+	/* one thread per allowed CPU, in order */
+	if (sched_getaffinity(0, sizeof(rAllowed), &rAllowed) == 0) {
+
+		for (int c = 0; c < CPU_SETSIZE; c++) {
+
+			if (CPU_ISSET(c, &rAllowed)) {
+				aCpus[iCpus++] = c;
+			}
+		}
+	}
+
+	if (pOptions->iMemStress > 0) {
+
+		iSlice = (size_t) (pOptions->iMemStress / iNumThreads / iBuffer) * iBuffer;
+
+		if (iSlice < iBuffer) {
+			iSlice = iBuffer;
+		}
+
+		aSums = (uint64_t*) calloc(iNumThreads * (iSlice / iBuffer), sizeof(uint64_t)); /* arena memory starts zeroed: checksum 0 */
+	}
+
+	pCtx = rnd64_create(pOptions->iMode, pOptions->iEngine, pOptions->iSeed);
+
+	if (pCtx == NULL) {
+		fprintf(stderr, "\n%s: secure data generation unavailable.\n\n", pFilename);
+		free(aSums);
+		return EXIT_FAILURE;
+	}
+
+	pArena = arenaCreate(iSlice, iNumThreads);
+
+	if (pArena == NULL || (pOptions->iMemStress > 0 && aSums == NULL)) {
+		fprintf(stderr, "\n%s: insufficient memory for %u buffers of %zu bytes.\n\n", pFilename, iNumThreads, iSlice);
+		arenaDestroy(pArena);
+		rnd64_destroy(pCtx);
+		free(aSums);
+		return EXIT_FAILURE;
+	}
+
+	printf("\nsink: none  engine: %s  threads: %u%s  buffer: %u  kernels: %s\n", stressEngine(pOptions), iNumThreads, (iCpus >= iNumThreads) ? " (pinned)" : "", iBuffer, rnd64_isa());
+
+	if (pOptions->iMemStress > 0) {
+		printf("memstress: %zu MB working set, %s pages\n", iSlice * iNumThreads / (1024 * 1024), arenaPages(pArena));
+	}
+
+	if (pOptions->iDuration > 0) {
+		printf("duration: %"PRIu64" s\n", pOptions->iDuration);
+	}
+	else {
+		printf("size: %"PRIu64" bytes\n", pOptions->iBytes);
+	}
+
+	printf("\n");
+
+	for (unsigned int i = 0; i < iNumThreads; i++) {
+
+		memset(&aWorkers[i], 0, sizeof(StressWorker_t));
+		aWorkers[i].pCtx = rnd64_clone(pCtx);
+
+		if (aWorkers[i].pCtx == NULL) {
+			fprintf(stderr, "\n%s: generator initialisation failed.\n\n", pFilename);
+
+			for (unsigned int j = 0; j < i; j++) {
+				rnd64_destroy(aWorkers[j].pCtx);
+			}
+
+			arenaDestroy(pArena);
+			rnd64_destroy(pCtx);
+			free(aSums);
+			return EXIT_FAILURE;
+		}
+
+		/* sized: sections of one stream, as stream mode; timed: a stream per thread */
+		if (pOptions->iDuration > 0) {
+			rnd64_stream(aWorkers[i].pCtx, i);
+		}
+		else {
+			rnd64_seek(aWorkers[i].pCtx, i * iThreadBytes);
+			aWorkers[i].iBytes = (i == iNumThreads - 1) ? pOptions->iBytes - i * iThreadBytes : iThreadBytes;
+		}
+
+		aWorkers[i].pBuffer = (uint8_t*) arenaAcquire(pArena);
+		aWorkers[i].iBuffer = iBuffer;
+		aWorkers[i].iSlots = (pOptions->iMemStress > 0) ? iSlice / iBuffer : 0;
+		aWorkers[i].aSums = (aSums != NULL) ? aSums + i * (iSlice / iBuffer) : NULL;
+		aWorkers[i].iCpu = (iCpus >= iNumThreads) ? aCpus[i] : -1;
+		aWorkers[i].iThread = i;
+		aWorkers[i].pStop = &iStop;
+		aWorkers[i].pFinished = &iFinished;
+		aLast[i] = 0;
+	}
+
+	double fStart = getTime();
+	double fLast = fStart;
+	struct timespec tPoll = {0, (long) cSTRESS_POLL * 1000000L};
+
+	for (unsigned int i = 0; i < iNumThreads; i++) {
+
+		if (pthread_create(&rThreadID[i], NULL, stressWorker, &aWorkers[i]) != 0) {
+			fprintf(stderr, "\n%s: generator thread cannot be started.\n\n", pFilename);
+			__atomic_store_n(&iStop, 1, __ATOMIC_RELAXED);
+			iResult = EXIT_FAILURE;
+			break;
+		}
+
+		iStarted++;
+	}
+
+	/* reporter: per-thread MB/s since the last report */
+	while (__atomic_load_n(&iFinished, __ATOMIC_ACQUIRE) < iStarted) {
+
+		nanosleep(&tPoll, NULL);
+
+		double fNow = getTime();
+
+		if (pOptions->iDuration > 0 && fNow - fStart >= (double) pOptions->iDuration) {
+			__atomic_store_n(&iStop, 1, __ATOMIC_RELAXED);
+		}
+
+		if (fNow - fLast >= cSTRESS_INTERVAL) {
+
+			double fSum = 0;
+			double fMin = 0;
+			unsigned int iMin = 0;
+
+			printf("%6.0f s  ", fNow - fStart);
+
+			for (unsigned int i = 0; i < iNumThreads; i++) {
+
+				uint64_t iDone = __atomic_load_n(&aWorkers[i].iDone, __ATOMIC_RELAXED);
+				double fRate = (double) (iDone - aLast[i]) * cMBRECIP * cMBRECIP / (fNow - fLast);
+
+				printf(" %6.0f", fRate);
+				fSum += fRate;
+
+				if (i == 0 || fRate < fMin) {
+					fMin = fRate;
+					iMin = i;
+				}
+
+				aLast[i] = iDone;
+			}
+
+			printf("   total: %0.2f MB/s  slowest: t%u %0.0f%% of mean\n", fSum, iMin, (fSum > 0) ? 100 * fMin * iNumThreads / fSum : 0);
+			fflush(stdout);
+
+			fLast = fNow;
+		}
+	}
+
+	for (unsigned int i = 0; i < iNumThreads; i++) {
+
+		if (i < iStarted) {
+			pthread_join(rThreadID[i], NULL);
+		}
+
+		iTotal += aWorkers[i].iDone;
+		iErrors += aWorkers[i].iErrors;
+
+		if (aWorkers[i].iFailed) {
+			iResult = EXIT_FAILURE;
+		}
+
+		arenaRelease(pArena, aWorkers[i].pBuffer);
+		rnd64_destroy(aWorkers[i].pCtx);
+	}
+
+	double fTime = getTime() - fStart;
+
+	rnd64_destroy(pCtx);
+	arenaDestroy(pArena);
+	free(aSums);
+
+	printf("\ngenerated: %"PRIu64" bytes\n", iTotal);
+	printf("time: %d s %d ms\n", (int) fTime, (int) (fTime * 1000) % 1000);
+
+	if (fTime > 0) {
+		printf("MB/s: %0.2f  (per thread: %0.2f)\n", (iTotal * cMBRECIP * cMBRECIP) / fTime, (iTotal * cMBRECIP * cMBRECIP) / fTime / iNumThreads);
+	}
+
+	if (pOptions->iMemStress > 0) {
+		printf("memory errors: %"PRIu64"\n", iErrors);
+	}
+
+	printf("\n");
+
+	if (iErrors > 0) {
+		fprintf(stderr, "%s: %"PRIu64" memory errors detected.\n\n", pFilename, iErrors);
+		iResult = EXIT_FAILURE;
+	}
+
+	return iResult;
+}
+
+
+#elif _WIN64
+
+
+/**
+	* Generate with no output (Linux only: CPU pinning, per-thread reporting).
+	*
+	* @param   Options_t* pOptions
+	* @return  int, EXIT_FAILURE
+*/
+
+int stress(Options_t const* pOptions) {
+
+	(void) pOptions;
+	fprintf(stderr, "\n%s: --sink=none is not available on this platform.\n\n", pFilename);
+
+	return EXIT_FAILURE;
+}
+
+
+#endif
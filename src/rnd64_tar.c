@@ -0,0 +1,494 @@
+/**
+	* RND64
+	* rnd64_tar.c
+	*
+	* Streaming archive: --tar writes a POSIX ustar archive of the tree that --tree would create (--count files,
+	* --size or --size-dist, --fanout / --depth directories) to [file] or stdout, with no files on disk.
+	*
+	* @author        Martin Latter
+	* @copyright     Martin Latter, April 2014
+	* @version       0.42 mt
+	* @license       GNU GPL version 3.0 (GPL v3); https://www.gnu.org/licenses/gpl-3.0.html
+	* @link          https://github.com/Tinram/RND64.git
+	*
+	* Every member's size follows from the seed, so the whole archive layout is known up front: threads claim
+	* 1 MB chunks of the archive, build the headers falling in them in-line, fill payloads from the member's PCG32
+	* stream (as --tree), and hand the chunks to the ordered output stage (rnd64_output.c).
+	*
+	* Example:       rnd64 -a --tar --count 100000 --size-dist 4k:1m | tar -t | wc -l
+*/
+
+
+#include "rnd64.h"
+
+#ifdef __linux
+	#include <fcntl.h>
+	#include <errno.h>
+#endif
+
+
+#ifdef __linux
+
+
+/* constants */
+static size_t const cCHUNK = 1024 * KB;        /* archive chunk: unit of work and of output */
+static uint64_t const cBLOCK = 512;            /* tar block */
+static uint64_t const cRECORD = 20 * 512;      /* tar record: the archive is padded to whole records */
+static uint64_t const cSIZE_LIMIT = 077777777777ULL; /* ustar size field: 11 octal digits */
+static uint64_t const cMTIME = 1396310400;     /* member mtime, 2014-04-01 UTC: fixed, so a seeded archive is byte-reproducible */
+
+
+/* structs */
+typedef struct {
+	Options_t const* pOptions;
+	rnd64_ctx_t* pCtx;
+	Output_t* pOutput;
+	uint64_t* aOffsets;        /* archive offset of each member, and of the end-of-archive blocks */
+	uint64_t iDirs;            /* directory members, before the files */
+	uint64_t iMembers;
+	uint64_t iLeaves;
+	uint64_t iSeed;
+	uint64_t iArchive;         /* bytes, padded */
+	uint64_t iChunks;
+	uint64_t iNext;            /* next chunk to claim */
+	int iError;
+} Tar_t;
+
+
+/**
+	* Name and size of a member: interior and leaf directories level by level, then file n in leaf n % leaves.
+	*
+	* @param   Tar_t* pTar
+	* @param   uint64_t iMember
+	* @param   char* sName, destination (4096 bytes)
+	* @return  uint64_t, payload bytes, UINT64_MAX for a directory
+*/
+
+static uint64_t tarMember(Tar_t const* pTar, uint64_t iMember, char* sName) {
+
+	Options_t const* pOptions = pTar->pOptions;
+
+	if (iMember < pTar->iDirs) {
+
+		uint64_t iLevelDirs = pOptions->iFanout;
+		unsigned int iLevel = 1;
+
+		while (iMember >= iLevelDirs) {
+			iMember -= iLevelDirs;
+			iLevelDirs *= pOptions->iFanout;
+			iLevel++;
+		}
+
+		treePath(sName, iMember, iLevel, pOptions->iFanout);
+		strcat(sName, "/");
+
+		return UINT64_MAX;
+	}
+
+	uint64_t iFile = iMember - pTar->iDirs;
+
+	if (pOptions->iDepth > 0) {
+		treePath(sName, iFile % pTar->iLeaves, pOptions->iDepth, pOptions->iFanout);
+		snprintf(sName + strlen(sName), 32, "/f%08"PRIu64, iFile);
+	}
+	else {
+		snprintf(sName, 32, "f%08"PRIu64, iFile);
+	}
+
+	return treeFileSize(pOptions, pTar->iSeed, iFile);
+}
+
+
+/**
+	* Write a zero-padded, NUL-terminated octal field; sizes are checked against cSIZE_LIMIT up front.
+	*
+	* @param   char* pField
+	* @param   size_t iWidth, field bytes including the NUL
+	* @param   uint64_t iValue
+	* @return  void
+*/
+
+static void tarOctal(char* pField, size_t iWidth, uint64_t iValue) {
+
+	pField[iWidth - 1] = '\0';
+
+	for (size_t i = iWidth - 1; i > 0; i--) {
+		pField[i - 1] = (char) ('0' + (iValue & 7));
+		iValue >>= 3;
+	}
+}
+
+
+/**
+	* Build a member's ustar header block.
+	*
+	* @param   Tar_t* pTar
+	* @param   uint64_t iMember
+	* @param   uint8_t* pHeader, cBLOCK bytes
+	* @return  void
+*/
+
+static void tarHeader(Tar_t const* pTar, uint64_t iMember, uint8_t* pHeader) {
+
+	char sName[4096];
+	uint64_t iSize = tarMember(pTar, iMember, sName);
+	int iDir = (iSize == UINT64_MAX);
+	char* pField = (char*) pHeader;
+	unsigned int iSum = 0;
+
+	memset(pHeader, 0, cBLOCK);
+
+	memcpy(pField, sName, strlen(sName));                                         /* name */
+	snprintf(pField + 100, 8, "%07o", iDir ? 0755 : 0644);                        /* mode */
+	snprintf(pField + 108, 8, "%07o", 0);                                         /* uid */
+	snprintf(pField + 116, 8, "%07o", 0);                                         /* gid */
+	tarOctal(pField + 124, 12, iDir ? 0 : iSize);                                 /* size */
+	tarOctal(pField + 136, 12, cMTIME);                                           /* mtime */
+	memset(pField + 148, ' ', 8);                                                 /* checksum, as spaces */
+	pField[156] = iDir ? '5' : '0';                                               /* typeflag */
+	memcpy(pField + 257, "ustar", 6);                                             /* magic */
+	memcpy(pField + 263, "00", 2);                                                /* version */
+	snprintf(pField + 265, 32, "rnd64");                                          /* uname */
+	snprintf(pField + 297, 32, "rnd64");                                          /* gname */
+
+	for (unsigned int i = 0; i < cBLOCK; i++) {
+		iSum += pHeader[i];
+	}
+
+	snprintf(pField + 148, 8, "%06o", iSum);
+	pField[155] = ' ';
+}
+
+
+/**
+	* Fill the archive range [iStart, iStart + iLen): headers, payloads, padding and the end-of-archive zeros.
+	*
+	* @param   Tar_t* pTar
+	* @param   rnd64_ctx_t* pCtx, this thread's clone
+	* @param   uint8_t* pBuffer
+	* @param   uint64_t iStart
+	* @param   size_t iLen
+	* @return  int, 0 on success, -1 on failure (message printed)
+*/
+
+static int tarChunk(Tar_t const* pTar, rnd64_ctx_t* pCtx, uint8_t* pBuffer, uint64_t iStart, size_t iLen) {
+
+	uint64_t iPos = iStart;
+	uint64_t iEnd = iStart + iLen;
+	uint64_t iLow = 0;
+	uint64_t iHigh = pTar->iMembers;
+
+	/* member holding iStart: the last offset <= iStart */
+	while (iLow < iHigh) {
+
+		uint64_t iMid = iLow + (iHigh - iLow + 1) / 2;
+
+		if (pTar->aOffsets[iMid] <= iStart) {
+			iLow = iMid;
+		}
+		else {
+			iHigh = iMid - 1;
+		}
+	}
+
+	for (uint64_t m = iLow; iPos < iEnd; m++) {
+
+		uint8_t* pOut = pBuffer + (iPos - iStart);
+
+		if (m >= pTar->iMembers) { /* two zero blocks and the record padding */
+			memset(pOut, 0, (size_t) (iEnd - iPos));
+			break;
+		}
+
+		uint64_t iRel = iPos - pTar->aOffsets[m];
+		uint64_t iMemberEnd = (pTar->aOffsets[m + 1] < iEnd) ? pTar->aOffsets[m + 1] : iEnd;
+
+		while (iPos < iMemberEnd) {
+
+			pOut = pBuffer + (iPos - iStart);
+
+			if (iRel < cBLOCK) {
+
+				uint8_t aHeader[512];
+				size_t iCopy = (size_t) (cBLOCK - iRel);
+
+				if (iCopy > iMemberEnd - iPos) {
+					iCopy = (size_t) (iMemberEnd - iPos);
+				}
+
+				tarHeader(pTar, m, aHeader);
+				memcpy(pOut, aHeader + iRel, iCopy);
+				iPos += iCopy;
+				iRel += iCopy;
+				continue;
+			}
+
+			uint64_t iPayloadEnd = pTar->aOffsets[m] + cBLOCK;
+
+			if (m >= pTar->iDirs) {
+				iPayloadEnd += treeFileSize(pTar->pOptions, pTar->iSeed, m - pTar->iDirs);
+			}
+
+			if (iPos < iPayloadEnd) {
+
+				size_t iFill = (size_t) (((iPayloadEnd < iMemberEnd) ? iPayloadEnd : iMemberEnd) - iPos);
+
+				/* file n is stream n, as --tree */
+				rnd64_stream(pCtx, m - pTar->iDirs);
+				rnd64_seek(pCtx, iRel - cBLOCK);
+
+				if (rnd64_fill(pCtx, pOut, iFill) != 0) {
+					fprintf(stderr, "\n%s: insufficient crypto random bytes available.\n\n", pFilename);
+					return -1;
+				}
+
+				iPos += iFill;
+				iRel += iFill;
+				continue;
+			}
+
+			memset(pOut, 0, (size_t) (iMemberEnd - iPos)); /* payload padding to the block */
+			iPos = iMemberEnd;
+		}
+	}
+
+	return 0;
+}
+
+
+/**
+	* Thread function: claim archive chunks, fill them and queue them for output.
+	*
+	* @param   void pointer st, Tar_t struct
+	* @return  void* / null
+*/
+
+static void* tarWorker(void* st) {
+
+	Tar_t* pTar = (Tar_t*) st;
+	rnd64_ctx_t* pCtx = rnd64_clone(pTar->pCtx);
+
+	if (pCtx == NULL) {
+		fprintf(stderr, "\n%s: generator initialisation failed.\n\n", pFilename);
+		__atomic_store_n(&pTar->iError, 1, __ATOMIC_RELAXED);
+		outputAbort(pTar->pOutput);
+	}
+
+	while (pCtx != NULL && ! __atomic_load_n(&pTar->iError, __ATOMIC_RELAXED)) {
+
+		uint64_t iChunk = __atomic_fetch_add(&pTar->iNext, 1, __ATOMIC_RELAXED);
+
+		if (iChunk >= pTar->iChunks) {
+			break;
+		}
+
+		uint64_t iStart = iChunk * cCHUNK;
+		size_t iLen = (pTar->iArchive - iStart < cCHUNK) ? (size_t) (pTar->iArchive - iStart) : cCHUNK;
+		uint8_t* pBuffer = outputAcquire(pTar->pOutput, iChunk);
+
+		if (pBuffer == NULL || tarChunk(pTar, pCtx, pBuffer, iStart, iLen) != 0) {
+			__atomic_store_n(&pTar->iError, 1, __ATOMIC_RELAXED);
+			outputAbort(pTar->pOutput); /* no gap in the sequence left for others to wait on */
+			break;
+		}
+
+		outputCommit(pTar->pOutput, iChunk, iLen);
+	}
+
+	rnd64_destroy(pCtx);
+
+	return NULL;
+}
+
+
+/**
+	* Write a ustar archive of --count generated files.
+	*
+	* @param   Options_t* pOptions
+	* @return  int, EXIT_SUCCESS / EXIT_FAILURE
+*/
+
+int tarStream(Options_t const* pOptions) {
+
+	char sName[4096];
+	unsigned int iNumThreads = pOptions->iThreads;
+	unsigned int iStarted = 0;
+	uint64_t iLevelDirs = 1;
+	int iFd = STDOUT_FILENO;
+	Tar_t tar;
+
+	memset(&tar, 0, sizeof(tar));
+	tar.pOptions = pOptions;
+	tar.iLeaves = 1;
+
+	for (unsigned int k = 0; k < pOptions->iDepth; k++) {
+		iLevelDirs *= pOptions->iFanout;
+		tar.iDirs += iLevelDirs;
+		tar.iLeaves = iLevelDirs;
+	}
+
+	tar.iMembers = tar.iDirs + pOptions->iCount;
+
+	/* the longest name: the last file in the last leaf */
+	if (pOptions->iDepth > 0) {
+		treePath(sName, tar.iLeaves - 1, pOptions->iDepth, pOptions->iFanout);
+		snprintf(sName + strlen(sName), 32, "/f%08"PRIu64, pOptions->iCount - 1);
+	}
+	else {
+		snprintf(sName, 32, "f%08"PRIu64, pOptions->iCount - 1);
+	}
+
+	if (strlen(sName) >= 100) {
+		fprintf(stderr, "\n%s: --tar member names are limited to 99 characters (ustar): reduce --depth / --fanout.\n\n", pFilename);
+		return EXIT_FAILURE;
+	}
+
+	if (pOptions->iSizeMax > cSIZE_LIMIT) {
+		fprintf(stderr, "\n%s: --tar file sizes are limited to 8G - 1 byte (ustar).\n\n", pFilename);
+		return EXIT_FAILURE;
+	}
+
+	tar.pCtx = rnd64_create(pOptions->iMode, pOptions->iEngine, pOptions->iSeed);
+	tar.aOffsets = (uint64_t*) malloc((tar.iMembers + 1) * sizeof(uint64_t));
+
+	if (tar.pCtx == NULL || tar.aOffsets == NULL) {
+		fprintf(stderr, "\n%s: %s.\n\n", pFilename, (tar.pCtx == NULL) ? "secure data generation unavailable" : "insufficient memory for the archive index");
+		free(tar.aOffsets);
+		rnd64_destroy(tar.pCtx);
+		return EXIT_FAILURE;
+	}
+
+	tar.iSeed = rnd64_seed(tar.pCtx);
+
+	/* layout: header block and whole payload blocks per member */
+	uint64_t iOffset = 0;
+
+	for (uint64_t m = 0; m < tar.iMembers; m++) {
+
+		tar.aOffsets[m] = iOffset;
+		iOffset += cBLOCK;
+
+		if (m >= tar.iDirs) {
+			iOffset += (treeFileSize(pOptions, tar.iSeed, m - tar.iDirs) + cBLOCK - 1) & ~(cBLOCK - 1);
+		}
+	}
+
+	tar.aOffsets[tar.iMembers] = iOffset;
+	tar.iArchive = (iOffset + 2 * cBLOCK + cRECORD - 1) / cRECORD * cRECORD;
+	tar.iChunks = (tar.iArchive + cCHUNK - 1) / cCHUNK;
+
+	if (iNumThreads > tar.iChunks) {
+		iNumThreads = (unsigned int) tar.iChunks;
+	}
+
+	if (pOptions->sOutput != NULL) {
+
+		iFd = open(pOptions->sOutput, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+		if (iFd < 0) {
+			fprintf(stderr, "\n%s: output file cannot be written.\n(check write permissions / filename characters)\n\n", pFilename);
+			free(tar.aOffsets);
+			rnd64_destroy(tar.pCtx);
+			return EXIT_FAILURE;
+		}
+	}
+	else if (pOptions->iPipeSize > 0) {
+		setPipeSize(STDOUT_FILENO, pOptions->iPipeSize);
+	}
+
+	/* queue: two chunks per thread in flight */
+	tar.pOutput = outputCreate(iFd, cCHUNK, 2 * iNumThreads);
+
+	if (tar.pOutput == NULL) {
+		fprintf(stderr, "\n%s: insufficient memory for output buffers.\n\n", pFilename);
+
+		if (iFd != STDOUT_FILENO) {
+			close(iFd);
+		}
+
+		free(tar.aOffsets);
+		rnd64_destroy(tar.pCtx);
+		return EXIT_FAILURE;
+	}
+
+	pthread_t* rThreadID = (pthread_t*) calloc(iNumThreads, sizeof(pthread_t));
+
+	if (rThreadID == NULL) {
+		fprintf(stderr, "\n%s: insufficient memory for %u threads.\n\n", pFilename, iNumThreads);
+		tar.iError = 1;
+		outputAbort(tar.pOutput);
+		iNumThreads = 0;
+	}
+
+	double fStart = getTime();
+
+	for (unsigned int i = 0; i < iNumThreads; i++) {
+
+		if (pthread_create(&rThreadID[i], NULL, tarWorker, &tar) != 0) {
+			fprintf(stderr, "\n%s: writer thread cannot be started.\n\n", pFilename);
+			__atomic_store_n(&tar.iError, 1, __ATOMIC_RELAXED);
+			outputAbort(tar.pOutput);
+			break;
+		}
+
+		iStarted++;
+	}
+
+	for (unsigned int i = 0; i < iStarted; i++) {
+		pthread_join(rThreadID[i], NULL);
+	}
+
+	free(rThreadID);
+
+	if (outputFinish(tar.pOutput, tar.iError ? 0 : tar.iChunks, NULL) != 0) {
+		tar.iError = 1;
+	}
+
+	double fTime = getTime() - fStart;
+
+	if (iFd != STDOUT_FILENO) {
+
+		if (close(iFd) != 0) {
+			fprintf(stderr, "\n%s: output file write failure (%s).\n\n", pFilename, strerror(errno));
+			tar.iError = 1;
+		}
+
+		printf("\n%s: %"PRIu64" files, %"PRIu64" directories\n\n", pOptions->sOutput, pOptions->iCount, tar.iDirs);
+		printf("size: %"PRIu64" bytes\n", tar.iArchive);
+		printf("time: %d s %d ms\n", (int) fTime, (int) (fTime * 1000) % 1000);
+
+		if (fTime > 0) {
+			printf("files/s: %0.2f\n", pOptions->iCount / fTime);
+			printf("MB/s: %0.2f\n", (tar.iArchive * cMBRECIP * cMBRECIP) / fTime);
+		}
+
+		printf("\n");
+	}
+
+	free(tar.aOffsets);
+	rnd64_destroy(tar.pCtx);
+
+	return tar.iError ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+
+#elif _WIN64
+
+
+/**
+	* Write a ustar archive of --count generated files (Linux only: ordered output stage).
+	*
+	* @param   Options_t* pOptions
+	* @return  int, EXIT_FAILURE
+*/
+
+int tarStream(Options_t const* pOptions) {
+
+	(void) pOptions;
+	fprintf(stderr, "\n%s: --tar is not available on this platform.\n\n", pFilename);
+
+	return EXIT_FAILURE;
+}
+
+
+#endif
@@ -0,0 +1,386 @@
+/**
+	* RND64
+	* rnd64_tree.c
+	*
+	* Small-file mass creation: --count files spread over a --fanout / --depth directory tree, for
+	* filesystem and object-store metadata stress. The headline figure is files/s.
+	*
+	* @author        Martin Latter
+	* @copyright     Martin Latter, April 2014
+	* @version       0.42 mt
+	* @license       GNU GPL version 3.0 (GPL v3); https://www.gnu.org/licenses/gpl-3.0.html
+	* @link          https://github.com/Tinram/RND64.git
+	*
+	* Leaf directories are sharded across threads (leaf % threads), so no two threads create entries in the
+	* same directory. Each thread works through its leaves one at a time: one directory descriptor per leaf,
+	* then open, write and close each file with openat() relative names and one write() per file.
+	* File n is in leaf n % leaves, named f<n>, with PCG32 stream n of the seed: the tree is reproducible with -s.
+*/
+
+
+#include "rnd64.h"
+#include <math.h>
+
+#ifdef __linux
+	#include <fcntl.h>
+	#include <errno.h>
+	#include <sys/stat.h>
+#endif
+
+
+#ifdef __linux
+
+
+/* structs */
+typedef struct {
+	Options_t const* pOptions;
+	rnd64_ctx_t* pCtx;
+	int iRootFd;
+	Arena_t* pArena;           /* one file buffer per thread */
+	uint64_t iLeaves;
+	unsigned int iShard;       /* thread number */
+	unsigned int iShards;      /* thread count */
+	uint64_t iFiles;           /* results */
+	uint64_t iBytes;
+	int iError;
+} TreeWorker_t;
+
+
+/**
+	* Relative path of a directory: one d<nnn> component per level.
+	*
+	* @param   char* sPath, destination (4096 bytes)
+	* @param   uint64_t iDir, directory number within its level
+	* @param   unsigned int iLevel, levels below the root
+	* @param   unsigned int iFanout
+	* @return  void
+*/
+
+void treePath(char* sPath, uint64_t iDir, unsigned int iLevel, unsigned int iFanout) {
+
+	size_t iLen = 0;
+	uint64_t iDiv = 1;
+
+	sPath[0] = '.';
+	sPath[1] = '\0';
+
+	for (unsigned int k = 1; k < iLevel; k++) {
+		iDiv *= iFanout;
+	}
+
+	for (unsigned int k = 0; k < iLevel; k++) {
+		iLen += (size_t) snprintf(sPath + iLen, 4096 - iLen, "%sd%03u", (k > 0) ? "/" : "", (unsigned int) ((iDir / iDiv) % iFanout));
+		iDiv /= iFanout;
+	}
+}
+
+
+/**
+	* Size of file n: fixed, or log-uniform over --size-dist (splitmix64 of seed and file number).
+	*
+	* @param   Options_t* pOptions
+	* @param   uint64_t iSeed
+	* @param   uint64_t iFile
+	* @return  uint64_t, bytes
+*/
+
+uint64_t treeFileSize(Options_t const* pOptions, uint64_t iSeed, uint64_t iFile) {
+
+	if (pOptions->iSizeMin == pOptions->iSizeMax) {
+		return pOptions->iSizeMax;
+	}
+
+	uint64_t z = iSeed + (iFile + 1) * 0x9E3779B97F4A7C15ULL;
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	z ^= z >> 31;
+
+	double fUnit = (double) (z >> 11) * (1.0 / 9007199254740992.0);
+	double fLogMin = log((double) pOptions->iSizeMin);
+	double fLogMax = log((double) pOptions->iSizeMax);
+	uint64_t iSize = (uint64_t) exp(fLogMin + fUnit * (fLogMax - fLogMin));
+
+	if (iSize < pOptions->iSizeMin) {
+		iSize = pOptions->iSizeMin;
+	}
+
+	return (iSize > pOptions->iSizeMax) ? pOptions->iSizeMax : iSize;
+}
+
+
+/**
+	* Thread function: create this shard's leaf directories and their files.
+	*
+	* @param   void pointer st, TreeWorker_t struct
+	* @return  void* / null
+*/
+
+static void* treeWorker(void* st) {
+
+	TreeWorker_t* pWorker = (TreeWorker_t*) st;
+	Options_t const* pOptions = pWorker->pOptions;
+	uint64_t iSeed = rnd64_seed(pWorker->pCtx);
+	uint8_t* pBuffer = (uint8_t*) arenaAcquire(pWorker->pArena); /* one per thread: never NULL */
+
+	char sPath[4096];
+	char sName[32];
+
+	for (uint64_t iLeaf = pWorker->iShard; iLeaf < pWorker->iLeaves && ! pWorker->iError; iLeaf += pWorker->iShards) {
+
+		treePath(sPath, iLeaf, pOptions->iDepth, pOptions->iFanout);
+
+		if (pOptions->iDepth > 0 && mkdirat(pWorker->iRootFd, sPath, 0755) != 0 && errno != EEXIST) {
+			fprintf(stderr, "\n%s: directory '%s' cannot be created (%s).\n\n", pFilename, sPath, strerror(errno));
+			pWorker->iError = 1;
+			break;
+		}
+
+		int iDirFd = openat(pWorker->iRootFd, sPath, O_RDONLY | O_DIRECTORY);
+
+		if (iDirFd < 0) {
+			fprintf(stderr, "\n%s: directory '%s' cannot be opened (%s).\n\n", pFilename, sPath, strerror(errno));
+			pWorker->iError = 1;
+			break;
+		}
+
+		for (uint64_t iFile = iLeaf; iFile < pOptions->iCount; iFile += pWorker->iLeaves) {
+
+			uint64_t iSize = treeFileSize(pOptions, iSeed, iFile);
+
+			rnd64_stream(pWorker->pCtx, iFile);
+
+			if (rnd64_fill(pWorker->pCtx, pBuffer, iSize) != 0) {
+				fprintf(stderr, "\n%s: insufficient crypto random bytes available.\n\n", pFilename);
+				pWorker->iError = 1;
+				break;
+			}
+
+			snprintf(sName, sizeof(sName), "f%08"PRIu64, iFile);
+
+			int iFd = openat(iDirFd, sName, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+			if (iFd < 0) {
+				fprintf(stderr, "\n%s: file '%s/%s' cannot be created (%s).\n\n", pFilename, sPath, sName, strerror(errno));
+				pWorker->iError = 1;
+				break;
+			}
+
+			for (uint64_t i = 0; i < iSize; ) {
+
+				ssize_t iWritten = write(iFd, pBuffer + i, iSize - i);
+
+				if (iWritten <= 0) {
+					fprintf(stderr, "\n%s: write failure (%s).\n\n", pFilename, strerror(errno));
+					pWorker->iError = 1;
+					break;
+				}
+
+				i += (uint64_t) iWritten;
+			}
+
+			close(iFd);
+
+			if (pWorker->iError) {
+				break;
+			}
+
+			pWorker->iFiles++;
+			pWorker->iBytes += iSize;
+		}
+
+		close(iDirFd);
+	}
+
+	arenaRelease(pWorker->pArena, pBuffer);
+
+	return NULL;
+}
+
+
+/**
+	* Create a directory tree of --count small files.
+	*
+	* @param   Options_t* pOptions
+	* @return  int, EXIT_SUCCESS / EXIT_FAILURE
+*/
+
+int createTree(Options_t const* pOptions) {
+
+	char sPath[4096];
+	rnd64_ctx_t* pCtx = NULL;
+	uint64_t iLeaves = 1;
+	uint64_t iDirs = 0;
+	uint64_t iFiles = 0;
+	uint64_t iBytes = 0;
+	unsigned int iNumThreads = pOptions->iThreads;
+	unsigned int iStarted = 0;
+	int iRootFd = -1;
+	int iError = 0;
+	Arena_t* pArena = NULL;
+	double fStart = 0;
+	double fTime = 0;
+
+	for (unsigned int k = 0; k < pOptions->iDepth; k++) {
+		iLeaves *= pOptions->iFanout;
+	}
+
+	/* one shard of leaves per thread */
+	if (iNumThreads > iLeaves) {
+		iNumThreads = (unsigned int) iLeaves;
+	}
+
+	pthread_t rThreadID[iNumThreads];
+	TreeWorker_t aWorkers[iNumThreads];
+
+	pCtx = rnd64_create(pOptions->iMode, pOptions->iEngine, pOptions->iSeed);
+
+	if (pCtx == NULL) {
+		fprintf(stderr, "\n%s: secure data generation unavailable.\n\n", pFilename);
+		return EXIT_FAILURE;
+	}
+
+	pArena = arenaCreate(pOptions->iSizeMax, iNumThreads);
+
+	if (pArena == NULL) {
+		fprintf(stderr, "\n%s: insufficient memory for %u file buffers of %"PRIu64" bytes.\n\n", pFilename, iNumThreads, pOptions->iSizeMax);
+		rnd64_destroy(pCtx);
+		return EXIT_FAILURE;
+	}
+
+	fStart = getTime();
+
+	if (mkdir(pOptions->sTree, 0755) != 0 && errno != EEXIST) {
+		fprintf(stderr, "\n%s: directory '%s' cannot be created (%s).\n\n", pFilename, pOptions->sTree, strerror(errno));
+		arenaDestroy(pArena);
+		rnd64_destroy(pCtx);
+		return EXIT_FAILURE;
+	}
+
+	iRootFd = open(pOptions->sTree, O_RDONLY | O_DIRECTORY);
+
+	if (iRootFd < 0) {
+		fprintf(stderr, "\n%s: directory '%s' cannot be opened (%s).\n\n", pFilename, pOptions->sTree, strerror(errno));
+		arenaDestroy(pArena);
+		rnd64_destroy(pCtx);
+		return EXIT_FAILURE;
+	}
+
+	/* interior levels, top down; leaves are created by their shard's thread */
+	for (unsigned int iLevel = 1; iLevel < pOptions->iDepth; iLevel++) {
+
+		uint64_t iLevelDirs = 1;
+
+		for (unsigned int k = 0; k < iLevel; k++) {
+			iLevelDirs *= pOptions->iFanout;
+		}
+
+		for (uint64_t d = 0; d < iLevelDirs; d++) {
+
+			treePath(sPath, d, iLevel, pOptions->iFanout);
+
+			if (mkdirat(iRootFd, sPath, 0755) != 0 && errno != EEXIST) {
+				fprintf(stderr, "\n%s: directory '%s' cannot be created (%s).\n\n", pFilename, sPath, strerror(errno));
+				close(iRootFd);
+				arenaDestroy(pArena);
+				rnd64_destroy(pCtx);
+				return EXIT_FAILURE;
+			}
+		}
+
+		iDirs += iLevelDirs;
+	}
+
+	if (pOptions->iDepth > 0) {
+		iDirs += iLeaves;
+	}
+
+	for (unsigned int i = 0; i < iNumThreads; i++) {
+
+		memset(&aWorkers[i], 0, sizeof(TreeWorker_t));
+		aWorkers[i].pOptions = pOptions;
+		aWorkers[i].iRootFd = iRootFd;
+		aWorkers[i].pArena = pArena;
+		aWorkers[i].iLeaves = iLeaves;
+		aWorkers[i].iShard = i;
+		aWorkers[i].iShards = iNumThreads;
+		aWorkers[i].pCtx = rnd64_clone(pCtx);
+
+		if (aWorkers[i].pCtx == NULL) {
+			fprintf(stderr, "\n%s: generator initialisation failed.\n\n", pFilename);
+
+			for (unsigned int j = 0; j < i; j++) {
+				rnd64_destroy(aWorkers[j].pCtx);
+			}
+
+			close(iRootFd);
+			arenaDestroy(pArena);
+			rnd64_destroy(pCtx);
+			return EXIT_FAILURE;
+		}
+	}
+
+	for (unsigned int i = 0; i < iNumThreads; i++) {
+
+		if (pthread_create(&rThreadID[i], NULL, treeWorker, &aWorkers[i]) != 0) {
+			fprintf(stderr, "\n%s: writer thread cannot be started.\n\n", pFilename);
+			iError = 1;
+			break;
+		}
+
+		iStarted++;
+	}
+
+	for (unsigned int i = 0; i < iStarted; i++) {
+
+		pthread_join(rThreadID[i], NULL);
+
+		iFiles += aWorkers[i].iFiles;
+		iBytes += aWorkers[i].iBytes;
+		iError |= aWorkers[i].iError;
+	}
+
+	for (unsigned int i = 0; i < iNumThreads; i++) {
+		rnd64_destroy(aWorkers[i].pCtx);
+	}
+
+	fTime = getTime() - fStart;
+
+	close(iRootFd);
+	arenaDestroy(pArena);
+	rnd64_destroy(pCtx);
+
+	printf("\n%s: %"PRIu64" of %"PRIu64" files generated in %"PRIu64" directories\n\n", pOptions->sTree, iFiles, pOptions->iCount, iDirs);
+	printf("size: %"PRIu64" bytes\n", iBytes);
+	printf("time: %d s %d ms\n", (int) fTime, (int) (fTime * 1000) % 1000);
+
+	if (fTime > 0) {
+		printf("files/s: %0.2f\n", iFiles / fTime);
+		printf("MB/s: %0.2f\n", (iBytes * cMBRECIP * cMBRECIP) / fTime);
+	}
+
+	printf("\n");
+
+	return iError ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+
+#elif _WIN64
+
+
+/**
+	* Create a directory tree of --count small files (Linux only: openat()).
+	*
+	* @param   Options_t* pOptions
+	* @return  int, EXIT_FAILURE
+*/
+
+int createTree(Options_t const* pOptions) {
+
+	(void) pOptions;
+	fprintf(stderr, "\n%s: --tree is not available on this platform.\n\n", pFilename);
+
+	return EXIT_FAILURE;
+}
+
+
+#endif
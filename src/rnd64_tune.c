@@ -0,0 +1,571 @@
+/**
+	* RND64
+	* rnd64_tune.c
+	*
+	* Startup autotuner: --tune calibrates stream buffer size, thread count and pipe size on this host, through
+	* the same ordered output stage (streamRun()) as stdout and [file] runs, and saves the winners to a per-host
+	* profile that later runs load at startup.
+	*
+	* @author        Martin Latter
+	* @copyright     Martin Latter, April 2014
+	* @version       0.42 mt
+	* @license       GNU GPL version 3.0 (GPL v3); https://www.gnu.org/licenses/gpl-3.0.html
+	* @link          https://github.com/Tinram/RND64.git
+	*
+	* Profile:       $XDG_CACHE_HOME/rnd64/<hostname>.profile (default ~/.cache/rnd64/), one line per mode:
+	*                mode=a buffer=262144 threads=4 pipe=1048576 cpus=4
+	*                The hostname keeps profiles apart on shared home directories; a profile made with a
+	*                different CPU count is ignored. -t on the command line overrides the profile's threads.
+*/
+
+
+#define _GNU_SOURCE /* F_SETPIPE_SZ */
+
+#include "rnd64.h"
+
+#ifdef __linux
+	#include <fcntl.h>
+	#include <errno.h>
+	#include <sys/stat.h>
+#endif
+
+
+#ifdef __linux
+
+
+/* constants */
+static uint64_t const cTUNE_BYTES = 64 * KB * KB;  /* per calibration run */
+static unsigned int const cTUNE_REPEATS = 2;       /* fastest run kept */
+static unsigned int const cTUNE_DRAIN = 1024 * KB; /* pipe reader buffer */
+
+
+/**
+	* Mode letter of the command-line switch, as used in the profile.
+	*
+	* @param   Options_t* pOptions
+	* @return  char
+*/
+
+static char tuneMode(Options_t const* pOptions) {
+
+	if (pOptions->iEngine == RND64_ENGINE_CRYPTO) {
+		return 'c';
+	}
+
+	return (pOptions->iMode == RND64_MODE_SINGLE) ? 'f' : (pOptions->iMode == RND64_MODE_RESTRICTED) ? 'r' : 'a';
+}
+
+
+/**
+	* Path of this host's profile, optionally creating its directory.
+	*
+	* @param   char* sPath, destination (4096 bytes)
+	* @param   int iCreate, create the cache directory
+	* @return  int, 0 on success, -1 if there is no cache location
+*/
+
+static int profilePath(char* sPath, int iCreate) {
+
+	char const* sCache = getenv("XDG_CACHE_HOME");
+	char const* sHome = getenv("HOME");
+	char sHost[256];
+	size_t iLen = 0;
+
+	if (gethostname(sHost, sizeof(sHost)) != 0) {
+		strcpy(sHost, "localhost");
+	}
+
+	sHost[sizeof(sHost) - 1] = '\0';
+
+	if (sCache != NULL && sCache[0] != '\0') {
+		iLen = (size_t) snprintf(sPath, 4096, "%s", sCache);
+	}
+	else if (sHome != NULL && sHome[0] != '\0') {
+		iLen = (size_t) snprintf(sPath, 4096, "%s/.cache", sHome);
+	}
+	else {
+		return -1;
+	}
+
+	if (iLen >= 4000) {
+		return -1;
+	}
+
+	if (iCreate) {
+		mkdir(sPath, 0755); /* cache base: EEXIST, or the error surfaces below */
+	}
+
+	iLen += (size_t) snprintf(sPath + iLen, 4096 - iLen, "/rnd64");
+
+	if (iCreate && mkdir(sPath, 0755) != 0 && errno != EEXIST) {
+		return -1;
+	}
+
+	snprintf(sPath + iLen, 4096 - iLen, "/%s.profile", sHost);
+
+	return 0;
+}
+
+
+/**
+	* Apply this host's profile for the selected mode: buffer size, pipe size, and threads unless -t was given.
+	* Stream/file output only, the path --tune measures; a missing or mismatched profile leaves the defaults.
+	*
+	* @param   Options_t* pOptions
+	* @return  void
+*/
+
+void loadProfile(Options_t* pOptions) {
+
+	char sPath[4096];
+	char sLine[256];
+	char cMode = 0;
+	unsigned int iBuffer = 0;
+	unsigned int iThreads = 0;
+	unsigned int iPipe = 0;
+	unsigned int iCpus = 0;
+	FILE* pProfile = NULL;
+
+	if (pOptions->iSinkNone || pOptions->iTar || pOptions->sTree != NULL || pOptions->sTcp != NULL || pOptions->sUdp != NULL || pOptions->iCount > 0 || pOptions->iRandomOrder) {
+		return;
+	}
+
+	if (profilePath(sPath, 0) != 0 || (pProfile = fopen(sPath, "r")) == NULL) {
+		return;
+	}
+
+	while (fgets(sLine, sizeof(sLine), pProfile) != NULL) {
+
+		if (sscanf(sLine, "mode=%c buffer=%u threads=%u pipe=%u cpus=%u", &cMode, &iBuffer, &iThreads, &iPipe, &iCpus) != 5) {
+			continue;
+		}
+
+		if (cMode != tuneMode(pOptions) || iCpus != rnd64_cpu_count()) {
+			continue;
+		}
+
+		if (iBuffer >= 4 * KB && iBuffer <= cBUFFER_MAX) {
+			pOptions->iBuffer = iBuffer;
+		}
+
+		if (pOptions->iThreads == 0 && iThreads > 0 && iThreads <= cTHREADS_MAX) {
+			pOptions->iThreads = iThreads;
+		}
+
+		pOptions->iPipeSize = iPipe;
+	}
+
+	fclose(pProfile);
+}
+
+
+/**
+	* Resize a pipe with F_SETPIPE_SZ; no effect on other file types.
+	*
+	* @param   int iFd
+	* @param   unsigned int iSize, bytes, 0 to leave unchanged
+	* @return  unsigned int, pipe capacity, 0 if not a pipe
+*/
+
+unsigned int setPipeSize(int iFd, unsigned int iSize) {
+
+	struct stat rStat;
+
+	if (fstat(iFd, &rStat) != 0 || ! S_ISFIFO(rStat.st_mode)) {
+		return 0;
+	}
+
+	if (iSize > 0) {
+		fcntl(iFd, F_SETPIPE_SZ, (int) iSize);
+	}
+
+	int iCapacity = fcntl(iFd, F_GETPIPE_SZ);
+
+	return (iCapacity > 0) ? (unsigned int) iCapacity : 0;
+}
+
+
+/**
+	* Largest pipe capacity an unprivileged process may set.
+	*
+	* @param   void
+	* @return  unsigned int, bytes, 0 if unknown
+*/
+
+unsigned int pipeMaxSize(void) {
+
+	unsigned int iPipeMax = 0;
+	FILE* pMax = fopen("/proc/sys/fs/pipe-max-size", "r");
+
+	if (pMax != NULL) {
+
+		if (fscanf(pMax, "%u", &iPipeMax) != 1) {
+			iPipeMax = 0;
+		}
+
+		fclose(pMax);
+	}
+
+	return iPipeMax;
+}
+
+
+/**
+	* Thread function: drain the read end of a calibration pipe.
+	*
+	* @param   void pointer st, int file descriptor
+	* @return  void* / null
+*/
+
+static void* drainPipe(void* st) {
+
+	int iFd = *(int*) st;
+	uint8_t* pBuffer = (uint8_t*) malloc(cTUNE_DRAIN);
+
+	if (pBuffer != NULL) {
+		while (read(iFd, pBuffer, cTUNE_DRAIN) > 0) {}
+		free(pBuffer);
+	}
+
+	return NULL;
+}
+
+
+/**
+	* One calibration run: cTUNE_BYTES through the ordered output stage (streamRun()), as a normal stream run.
+	*
+	* @param   Options_t* pOptions
+	* @param   int iFd, sink
+	* @param   unsigned int iBuffer, bytes
+	* @param   unsigned int iThreads
+	* @return  double, MB/s, 0 on failure
+*/
+
+static double tuneRun(Options_t const* pOptions, int iFd, unsigned int iBuffer, unsigned int iThreads) {
+
+	Options_t run = *pOptions;
+	OutputStats_t stats;
+	double fTime = 0;
+
+	run.iBytes = cTUNE_BYTES;
+	run.iBuffer = iBuffer;
+	run.iThreads = iThreads;
+
+	if (streamRun(&run, iFd, &stats, &fTime) != 0 || fTime <= 0) {
+		return 0;
+	}
+
+	return cTUNE_BYTES * cMBRECIP * cMBRECIP / fTime;
+}
+
+
+/**
+	* Calibrate a buffer size and thread count writing to /dev/null (generation and write() overhead).
+	*
+	* @param   Options_t* pOptions
+	* @param   int iNull, /dev/null descriptor
+	* @param   unsigned int iBuffer
+	* @param   unsigned int iThreads
+	* @return  double, MB/s of the fastest repeat, 0 on failure
+*/
+
+static double tuneNull(Options_t const* pOptions, int iNull, unsigned int iBuffer, unsigned int iThreads) {
+
+	double fBest = 0;
+
+	for (unsigned int r = 0; r < cTUNE_REPEATS; r++) {
+
+		double fRate = tuneRun(pOptions, iNull, iBuffer, iThreads);
+
+		if (fRate == 0) {
+			return 0;
+		}
+
+		if (fRate > fBest) {
+			fBest = fRate;
+		}
+	}
+
+	return fBest;
+}
+
+
+/**
+	* Calibrate a pipe capacity: the stream is written into a pipe drained by a reader thread.
+	*
+	* @param   Options_t* pOptions
+	* @param   unsigned int iBuffer
+	* @param   unsigned int iThreads
+	* @param   unsigned int* pPipe, requested capacity; set to the capacity granted
+	* @return  double, MB/s of the fastest repeat, 0 on failure
+*/
+
+static double tunePipe(Options_t const* pOptions, unsigned int iBuffer, unsigned int iThreads, unsigned int* pPipe) {
+
+	double fBest = 0;
+
+	for (unsigned int r = 0; r < cTUNE_REPEATS; r++) {
+
+		int aPipe[2];
+		pthread_t rReader;
+
+		if (pipe(aPipe) != 0) {
+			return 0;
+		}
+
+		*pPipe = setPipeSize(aPipe[1], *pPipe);
+
+		if (pthread_create(&rReader, NULL, drainPipe, &aPipe[0]) != 0) {
+			close(aPipe[0]);
+			close(aPipe[1]);
+			return 0;
+		}
+
+		double fRate = tuneRun(pOptions, aPipe[1], iBuffer, iThreads);
+
+		close(aPipe[1]);
+		pthread_join(rReader, NULL);
+		close(aPipe[0]);
+
+		if (fRate == 0) {
+			return 0;
+		}
+
+		if (fRate > fBest) {
+			fBest = fRate;
+		}
+	}
+
+	return fBest;
+}
+
+
+/**
+	* Write the profile line for this mode, keeping the other modes' lines.
+	*
+	* @param   Options_t* pOptions
+	* @param   unsigned int iBuffer
+	* @param   unsigned int iThreads
+	* @param   unsigned int iPipe
+	* @param   char* sPath, populated with the profile path (4096 bytes)
+	* @return  int, 0 on success, -1 on failure
+*/
+
+static int saveProfile(Options_t const* pOptions, unsigned int iBuffer, unsigned int iThreads, unsigned int iPipe, char* sPath) {
+
+	char sTemp[4200];
+	char sLine[256];
+	char cMode = tuneMode(pOptions);
+	FILE* pOld = NULL;
+	FILE* pNew = NULL;
+
+	if (profilePath(sPath, 1) != 0) {
+		return -1;
+	}
+
+	snprintf(sTemp, sizeof(sTemp), "%s.tmp", sPath);
+
+	pNew = fopen(sTemp, "w");
+
+	if (pNew == NULL) {
+		return -1;
+	}
+
+	pOld = fopen(sPath, "r");
+
+	if (pOld != NULL) {
+
+		while (fgets(sLine, sizeof(sLine), pOld) != NULL) {
+
+			if (strncmp(sLine, "mode=", 5) == 0 && sLine[5] != cMode) {
+				fputs(sLine, pNew);
+			}
+		}
+
+		fclose(pOld);
+	}
+
+	fprintf(pNew, "mode=%c buffer=%u threads=%u pipe=%u cpus=%u\n", cMode, iBuffer, iThreads, iPipe, rnd64_cpu_count());
+
+	if (fclose(pNew) != 0 || rename(sTemp, sPath) != 0) {
+		unlink(sTemp);
+		return -1;
+	}
+
+	return 0;
+}
+
+
+/**
+	* Calibrate buffer size and thread count, then pipe size, and save the winners to the host profile.
+	*
+	* @param   Options_t* pOptions
+	* @return  int, EXIT_SUCCESS / EXIT_FAILURE
+*/
+
+int tune(Options_t const* pOptions) {
+
+	static unsigned int const aBuffers[] = {16 * KB, 32 * KB, 64 * KB, 128 * KB, 256 * KB, 512 * KB, 1024 * KB};
+	static unsigned int const aPipes[] = {64 * KB, 256 * KB, 1024 * KB, 4096 * KB};
+
+	unsigned int iCpus = rnd64_cpu_count();
+	unsigned int aThreads[32];
+	unsigned int iThreadSteps = 0;
+	unsigned int iBestBuffer = cBUFFER;
+	unsigned int iBestThreads = iCpus;
+	unsigned int iBestPipe = 0;
+	unsigned int iPipeMax = 0;
+	double fBest = 0;
+	char sPath[4096];
+	int iNull = -1;
+
+	/* thread counts: powers of 2 up to the CPU count, and the CPU count */
+	for (unsigned int t = 1; t < iCpus && iThreadSteps < 31; t *= 2) {
+		aThreads[iThreadSteps++] = t;
+	}
+
+	aThreads[iThreadSteps++] = iCpus;
+
+	iNull = open("/dev/null", O_WRONLY);
+
+	if (iNull < 0) {
+		fprintf(stderr, "\n%s: /dev/null cannot be opened.\n\n", pFilename);
+		return EXIT_FAILURE;
+	}
+
+	/* page type the arena gets for the largest buffers */
+	Arena_t* pProbe = arenaCreate(cBUFFER_MAX, 2);
+
+	printf("\nRND64 tune: -%c, %u CPUs, %s kernels, %s buffer pages, %"PRIu64" bytes per run\n\n", tuneMode(pOptions), iCpus, rnd64_isa(), (pProbe != NULL) ? arenaPages(pProbe) : "no", cTUNE_BYTES);
+
+	arenaDestroy(pProbe);
+	printf("   buffer  threads      MB/s\n");
+
+	for (unsigned int b = 0; b < sizeof(aBuffers) / sizeof(aBuffers[0]); b++) {
+		for (unsigned int t = 0; t < iThreadSteps; t++) {
+
+			double fRate = tuneNull(pOptions, iNull, aBuffers[b], aThreads[t]);
+
+			if (fRate == 0) {
+				fprintf(stderr, "\n%s: calibration run failed.\n\n", pFilename);
+				close(iNull);
+				return EXIT_FAILURE;
+			}
+
+			printf("  %7u  %7u  %8.2f\n", aBuffers[b], aThreads[t], fRate);
+
+			if (fRate > fBest) {
+				fBest = fRate;
+				iBestBuffer = aBuffers[b];
+				iBestThreads = aThreads[t];
+			}
+		}
+	}
+
+	close(iNull);
+
+	/* pipe capacities up to the unprivileged limit */
+	iPipeMax = pipeMaxSize();
+
+	printf("\n     pipe      MB/s\n");
+
+	fBest = 0;
+
+	for (unsigned int p = 0; p < sizeof(aPipes) / sizeof(aPipes[0]); p++) {
+
+		unsigned int iPipe = aPipes[p];
+
+		if (iPipeMax > 0 && iPipe > iPipeMax) {
+			break;
+		}
+
+		double fRate = tunePipe(pOptions, iBestBuffer, iBestThreads, &iPipe);
+
+		if (iPipe == 0 || fRate == 0) {
+			continue;
+		}
+
+		printf("  %7u  %8.2f\n", iPipe, fRate);
+
+		if (fRate > fBest) {
+			fBest = fRate;
+			iBestPipe = iPipe;
+		}
+	}
+
+	printf("\nbest: buffer %u, threads %u, pipe %u\n", iBestBuffer, iBestThreads, iBestPipe);
+
+	if (saveProfile(pOptions, iBestBuffer, iBestThreads, iBestPipe, sPath) != 0) {
+		fprintf(stderr, "\n%s: profile cannot be written (%s).\n\n", pFilename, strerror(errno));
+		return EXIT_FAILURE;
+	}
+
+	printf("profile: %s\n\n", sPath);
+
+	return EXIT_SUCCESS;
+}
+
+
+#elif _WIN64
+
+
+/**
+	* Apply the host profile (Linux only: no profile on this platform).
+	*
+	* @param   Options_t* pOptions
+	* @return  void
+*/
+
+void loadProfile(Options_t* pOptions) {
+
+	(void) pOptions;
+}
+
+
+/**
+	* Resize a pipe (Linux only).
+	*
+	* @param   int iFd
+	* @param   unsigned int iSize
+	* @return  unsigned int, 0
+*/
+
+unsigned int setPipeSize(int iFd, unsigned int iSize) {
+
+	(void) iFd;
+	(void) iSize;
+
+	return 0;
+}
+
+
+/**
+	* Largest pipe capacity (Linux only).
+	*
+	* @param   void
+	* @return  unsigned int, 0
+*/
+
+unsigned int pipeMaxSize(void) {
+
+	return 0;
+}
+
+
+/**
+	* Calibrate and save a host profile (Linux only: F_SETPIPE_SZ).
+	*
+	* @param   Options_t* pOptions
+	* @return  int, EXIT_FAILURE
+*/
+
+int tune(Options_t const* pOptions) {
+
+	(void) pOptions;
+	fprintf(stderr, "\n%s: --tune is not available on this platform.\n\n", pFilename);
+
+	return EXIT_FAILURE;
+}
+
+
+#endif